@@ -0,0 +1,109 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "GainComputer.h"
+
+// Program-dependent ballistics, used in place of the fixed attack/release
+// filter when auto attack or auto release is on.
+//
+// The crest factor of the detector level is tracked as a peak-hold and a
+// mean of its square over crestMs, as in Giannoulis, Massberg and Reiss,
+// "Digital Dynamic Range Compressor Design" (JAES 2012).
+//   Auto release: two envelopes share the attack and release at the release
+//     time (fast) and slowReleaseFactor times it (slow). The result is the
+//     slow one on steady material (crest factor 3 dB, a sine) moving to the
+//     fast one on transient material (12 dB and up), so the gain recovers
+//     quickly after a hit but does not pump on sustained notes.
+//   Auto attack: the attack time is divided by half the squared crest factor,
+//     up to maxAttackSpeedup, so transients are caught faster than the body
+//     of a note. With auto release off both envelopes release alike.
+//
+// One sample of the step is plain arithmetic with no data-dependent branches
+// (the attack/release choice is a 0/1 blend), so a loop over independent
+// lanes, such as the multiband's bands, compiles to straight-line code.
+template <typename SampleType>
+struct AutoBallistics
+{
+    static constexpr float slowReleaseFactor = 8.0f;
+    static constexpr float maxAttackSpeedup = 8.0f;
+    static constexpr float crestMs = 200.0f;
+
+    // The state besides the fast envelope, which is the caller's own.
+    struct State
+    {
+        SampleType slow = 0;
+        SampleType peakSquared = 0;
+        SampleType meanSquared = 0;
+    };
+
+    struct Coefficients
+    {
+        SampleType attackLog2 = 0;
+        SampleType fastRelease = 0;
+        SampleType slowRelease = 0;
+        SampleType crest = 0;
+        SampleType maxSpeedup = 1;
+    };
+
+    // Times in ms, with the same definition as the fixed ballistics.
+    static Coefficients makeCoefficients(double sampleRate, float attackMs, float releaseMs,
+                                         bool autoAttack, bool autoRelease) noexcept
+    {
+        auto expFactor = -2.0 * juce::MathConstants<double>::pi * 1000.0 / sampleRate;
+        auto coefficient = [expFactor](float timeMs) { return timeMs < 1.0e-3f ? SampleType() : (SampleType)std::exp(expFactor / timeMs); };
+
+        Coefficients c;
+        c.attackLog2 = attackMs < 1.0e-3f ? (SampleType)-126 : (SampleType)(expFactor / attackMs / std::log(2.0));
+        c.fastRelease = coefficient(releaseMs);
+        c.slowRelease = autoRelease ? coefficient(releaseMs * slowReleaseFactor) : c.fastRelease;
+        c.crest = coefficient(crestMs);
+        c.maxSpeedup = autoAttack ? (SampleType)maxAttackSpeedup : (SampleType)1;
+        return c;
+    }
+
+    // Starts the auto state from a fixed envelope, so switching modes does
+    // not jump.
+    static State fromEnvelope(SampleType envelope) noexcept
+    {
+        return { envelope, envelope * envelope, envelope * envelope };
+    }
+
+    // One sample: advances 'envelope' (the fast one) and 'state', and returns
+    // the envelope for the gain computer.
+    static SampleType process(SampleType level, SampleType& envelope, State& state, const Coefficients& c) noexcept
+    {
+        constexpr auto steadyCrestSquared = (SampleType)2;
+        constexpr auto transientScale = (SampleType)1 / (SampleType)14; // 3 dB to 12 dB
+        constexpr auto tiny = (SampleType)1.0e-20;
+
+        auto squared = level * level;
+        state.meanSquared = squared + c.crest * (state.meanSquared - squared);
+        state.peakSquared = juce::jmax(squared, squared + c.crest * (state.peakSquared - squared));
+
+        auto crestSquared = (state.peakSquared + tiny) / (state.meanSquared + tiny);
+        auto speedup = juce::jlimit((SampleType)1, c.maxSpeedup, crestSquared * (SampleType)0.5);
+        auto attack = FastMath::exp2(c.attackLog2 * speedup);
+        auto transient = juce::jlimit((SampleType)0, (SampleType)1, (crestSquared - steadyCrestSquared) * transientScale);
+
+        envelope = follow(envelope, level, attack, c.fastRelease);
+        state.slow = follow(state.slow, level, attack, c.slowRelease);
+        return state.slow + transient * (envelope - state.slow);
+    }
+
+    // Advances the crest trackers over numSamples of silence, for the
+    // silence fast paths. The envelopes are below the floor by then.
+    static void skip(State& state, SampleType crestCoefficient, int numSamples) noexcept
+    {
+        auto decay = std::pow(crestCoefficient, (SampleType)numSamples);
+        state.peakSquared *= decay;
+        state.meanSquared *= decay;
+    }
+
+private:
+    static SampleType follow(SampleType env, SampleType level, SampleType attack, SampleType release) noexcept
+    {
+        auto rising = (SampleType)(level > env);
+        auto cte = release + rising * (attack - release);
+        return level + cte * (env - level);
+    }
+};
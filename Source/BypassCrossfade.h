@@ -0,0 +1,137 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Click-free bypass. The dry input is delayed by the processor's latency so
+// that it lines up with the processed signal, and the output crossfades
+// between the two over fadeSeconds.
+//
+// Once fully bypassed the caller can stop processing altogether. Its state is
+// then stale, so when the bypass is released it resets and calls
+// holdDry(latency): the output stays dry until the processed path has
+// refilled its delays, and only then fades back in.
+template <typename SampleType>
+class BypassCrossfade
+{
+public:
+    static constexpr double fadeSeconds = 0.02;
+
+    void prepare(double sampleRate, int maxChannels, int maxDelay, int maxBlockSize)
+    {
+        capacity = juce::nextPowerOfTwo(maxDelay + maxBlockSize);
+        numChannelsPrepared = juce::jmax(1, maxChannels);
+        ring.assign((size_t)numChannelsPrepared * (size_t)capacity, SampleType());
+        writePosition = 0;
+        delaySamples = juce::jmin(delaySamples, maxDelay);
+
+        mix.reset(sampleRate, fadeSeconds);
+        mix.setCurrentAndTargetValue(bypassed ? (SampleType)1 : (SampleType)0);
+        holdSamples = 0;
+    }
+
+    void setBypassed(bool shouldBeBypassed) noexcept
+    {
+        if (shouldBeBypassed == bypassed)
+            return;
+
+        bypassed = shouldBeBypassed;
+
+        if (bypassed)
+        {
+            holdSamples = 0;
+            mix.setTargetValue((SampleType)1);
+        }
+        else if (holdSamples == 0)
+        {
+            mix.setTargetValue((SampleType)0);
+        }
+    }
+
+    // Keeps the output dry for the next numSamples, then fades to processed.
+    void holdDry(int numSamples) noexcept
+    {
+        holdSamples = juce::jmax(1, numSamples);
+        mix.setCurrentAndTargetValue((SampleType)1);
+    }
+
+    void setDelay(int numSamples) noexcept { delaySamples = juce::jlimit(0, capacity - 1, numSamples); }
+
+    // Fully dry: the caller need not process at all.
+    bool isBypassed() const noexcept { return bypassed && ! mix.isSmoothing(); }
+
+    // Fully processed: process() would leave the block untouched.
+    bool isActive() const noexcept
+    {
+        return ! bypassed && holdSamples == 0 && ! mix.isSmoothing() && mix.getTargetValue() == SampleType();
+    }
+
+    // Call with the input, before it is processed in place, at most the
+    // prepared block size at a time; the processor splits longer host
+    // blocks.
+    void pushDry(const SampleType* const* channels, int numChannels, int numSamples) noexcept
+    {
+        jassert(delaySamples + numSamples <= capacity);
+        auto mask = capacity - 1;
+
+        for (int ch = 0; ch < juce::jmin(numChannels, numChannelsPrepared); ++ch)
+        {
+            auto* line = ring.data() + (size_t)ch * (size_t)capacity;
+
+            for (int i = 0; i < numSamples; ++i)
+                line[(writePosition + i) & mask] = channels[ch][i];
+        }
+    }
+
+    // Call with the processed block; mixes in the delayed dry signal.
+    void process(SampleType* const* channels, int numChannels, int numSamples) noexcept
+    {
+        numChannels = juce::jmin(numChannels, numChannelsPrepared);
+        auto mask = capacity - 1;
+        auto readPosition = writePosition - delaySamples;
+
+        if (isBypassed())
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto* line = ring.data() + (size_t)ch * (size_t)capacity;
+
+                for (int i = 0; i < numSamples; ++i)
+                    channels[ch][i] = line[(readPosition + i) & mask];
+            }
+        }
+        else if (! isActive())
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto amount = (SampleType)1;
+
+                if (holdSamples > 0)
+                {
+                    if (--holdSamples == 0 && ! bypassed)
+                        mix.setTargetValue((SampleType)0);
+                }
+                else
+                {
+                    amount = mix.getNextValue();
+                }
+
+                for (int ch = 0; ch < numChannels; ++ch)
+                {
+                    auto dry = ring[(size_t)ch * (size_t)capacity + (size_t)((readPosition + i) & mask)];
+                    channels[ch][i] += amount * (dry - channels[ch][i]);
+                }
+            }
+        }
+
+        writePosition = (writePosition + numSamples) & mask;
+    }
+
+private:
+    std::vector<SampleType> ring;
+    int capacity = 1, numChannelsPrepared = 0;
+    int writePosition = 0, delaySamples = 0;
+
+    bool bypassed = false;
+    int holdSamples = 0;
+    juce::SmoothedValue<SampleType> mix;
+};
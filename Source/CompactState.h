@@ -0,0 +1,206 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Binary plugin state: a fixed header followed by one (parameter ID hash,
+// plain value) pair per parameter, all little-endian. Loading it is a bounds
+// check and one pass over the pairs; nothing is parsed or allocated.
+//
+// When the header's layout hash matches this build's parameter list the
+// pairs are taken in order. Otherwise, for states saved by a build with
+// other parameters and for presets, each pair is looked up by its ID hash,
+// and parameters the state does not mention go to their defaults. Values are
+// stored in parameter units, so a later change of range keeps their meaning.
+//
+// Version 1. A later version may only append to the header (headerSize says
+// where the pairs start) and must keep the pair layout.
+class CompactState
+{
+public:
+    static constexpr juce::uint32 magic = 0x5453434f; // "OCST"
+    static constexpr juce::uint16 currentVersion = 1;
+
+    struct Header
+    {
+        juce::uint32 magic;
+        juce::uint16 version;
+        juce::uint16 headerSize;
+        juce::uint32 numParameters;
+        juce::uint32 layoutHash;
+    };
+
+    struct Entry
+    {
+        juce::uint32 idHash;
+        float value;
+    };
+
+    static_assert(sizeof(Header) == 16 && sizeof(Entry) == 8, "the layout is the file format");
+
+    // FNV-1a, so hashes are the same on every platform and JUCE version.
+    static juce::uint32 hashId(const juce::String& id) noexcept
+    {
+        juce::uint32 hash = 2166136261u;
+
+        for (auto* c = id.toRawUTF8(); *c != 0; ++c)
+            hash = (hash ^ (juce::uint8)*c) * 16777619u;
+
+        return hash;
+    }
+
+    static bool isCompactState(const void* data, size_t size) noexcept
+    {
+        return size >= sizeof(juce::uint32) && readUInt32(data) == magic;
+    }
+
+    // Encodes a list of (ID, value) pairs, for states built by hand such as
+    // factory presets. Their layout hash never matches, so they load by ID.
+    static juce::MemoryBlock encode(std::initializer_list<std::pair<const char*, float>> values)
+    {
+        juce::MemoryBlock block;
+        writeHeader(block, (juce::uint32)values.size(), 0);
+
+        for (auto& value : values)
+            writeEntry(block, hashId(value.first), value.second);
+
+        return block;
+    }
+
+    // The parameter list must not change after this.
+    explicit CompactState(const juce::Array<juce::AudioProcessorParameter*>& processorParameters)
+    {
+        for (auto* parameter : processorParameters)
+        {
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+            {
+                auto idHash = hashId(ranged->getParameterID());
+                parameters.push_back(ranged);
+                hashes.push_back(idHash);
+                lookup.push_back({ idHash, (int)lookup.size() });
+                layoutHash = (layoutHash ^ idHash) * 16777619u;
+            }
+        }
+
+        std::sort(lookup.begin(), lookup.end());
+    }
+
+    void save(juce::MemoryBlock& dest) const
+    {
+        dest.reset();
+        dest.ensureSize(sizeof(Header) + parameters.size() * sizeof(Entry));
+        writeHeader(dest, (juce::uint32)parameters.size(), layoutHash);
+
+        for (size_t i = 0; i < parameters.size(); ++i)
+        {
+            auto* parameter = parameters[i];
+            writeEntry(dest, hashes[i], parameter->convertFrom0to1(parameter->getValue()));
+        }
+    }
+
+    // Returns false, leaving the parameters alone, if the data is not a
+    // compact state this version can read.
+    bool load(const void* data, size_t size) const
+    {
+        if (size < sizeof(Header))
+            return false;
+
+        auto* bytes = static_cast<const char*>(data);
+        auto version = readUInt16(bytes + 4);
+        auto headerSize = (size_t)readUInt16(bytes + 6);
+        auto numEntries = (size_t)readUInt32(bytes + 8);
+
+        if (readUInt32(bytes) != magic || version < 1 || headerSize < sizeof(Header)
+            || numEntries > (size - headerSize) / sizeof(Entry))
+            return false;
+
+        auto* entries = bytes + headerSize;
+
+        if (readUInt32(bytes + 12) == layoutHash && numEntries == parameters.size())
+        {
+            for (size_t i = 0; i < numEntries; ++i)
+                setValue(parameters[i], readFloat(entries + i * sizeof(Entry) + 4));
+
+            return true;
+        }
+
+        std::vector<bool> found(parameters.size(), false);
+
+        for (size_t i = 0; i < numEntries; ++i)
+        {
+            auto* entry = entries + i * sizeof(Entry);
+            auto idHash = readUInt32(entry);
+            auto it = std::lower_bound(lookup.begin(), lookup.end(), std::make_pair(idHash, 0));
+
+            if (it != lookup.end() && it->first == idHash)
+            {
+                setValue(parameters[(size_t)it->second], readFloat(entry + 4));
+                found[(size_t)it->second] = true;
+            }
+        }
+
+        for (size_t i = 0; i < parameters.size(); ++i)
+            if (! found[i])
+                setNormalisedValue(parameters[i], parameters[i]->getDefaultValue());
+
+        return true;
+    }
+
+private:
+    static void setValue(juce::RangedAudioParameter* parameter, float value)
+    {
+        setNormalisedValue(parameter, parameter->convertTo0to1(value));
+    }
+
+    // Unchanged parameters are skipped, so reloading a session sends the
+    // host and the editor nothing for them.
+    static void setNormalisedValue(juce::RangedAudioParameter* parameter, float normalised)
+    {
+        if (parameter->getValue() != normalised)
+            parameter->setValueNotifyingHost(normalised);
+    }
+
+    static void writeHeader(juce::MemoryBlock& block, juce::uint32 numEntries, juce::uint32 hash)
+    {
+        writeUInt32(block, magic);
+        writeUInt16(block, currentVersion);
+        writeUInt16(block, (juce::uint16)sizeof(Header));
+        writeUInt32(block, numEntries);
+        writeUInt32(block, hash);
+    }
+
+    static void writeEntry(juce::MemoryBlock& block, juce::uint32 idHash, float value)
+    {
+        juce::uint32 bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        writeUInt32(block, idHash);
+        writeUInt32(block, bits);
+    }
+
+    static void writeUInt16(juce::MemoryBlock& block, juce::uint16 value)
+    {
+        value = juce::ByteOrder::swapIfBigEndian(value);
+        block.append(&value, sizeof(value));
+    }
+
+    static void writeUInt32(juce::MemoryBlock& block, juce::uint32 value)
+    {
+        value = juce::ByteOrder::swapIfBigEndian(value);
+        block.append(&value, sizeof(value));
+    }
+
+    static juce::uint16 readUInt16(const void* p) noexcept { return juce::ByteOrder::littleEndianShort(p); }
+    static juce::uint32 readUInt32(const void* p) noexcept { return juce::ByteOrder::littleEndianInt(p); }
+
+    static float readFloat(const void* p) noexcept
+    {
+        auto bits = readUInt32(p);
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    std::vector<juce::RangedAudioParameter*> parameters;
+    std::vector<juce::uint32> hashes;
+    std::vector<std::pair<juce::uint32, int>> lookup;
+    juce::uint32 layoutHash = 2166136261u;
+};
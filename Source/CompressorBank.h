@@ -0,0 +1,266 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "CompressorKernel.h"
+
+// Many independent compressors processed together, for hosts that run
+// hundreds of them, such as a server-side mixer with one per track.
+//
+// Each compressor is a lane. Everything per lane (curve, ballistics
+// coefficients, gains, envelopes) is a contiguous array indexed by lane, and
+// every step of a sample is a branch-free loop over the lanes, like the
+// multiband's loop over its bands. The compiler vectorises those loops to
+// the widest registers the target allows, so the lanes advance 4 at a time
+// at the default -march, 8 with AVX2 and 16 with AVX-512 (ONECOMP_ARCH
+// x86-64-v3 and x86-64-v4; GCC also needs -fno-trapping-math, which the
+// CMake build sets). The envelopes are recursions in time but not across
+// lanes, which is what makes this faster than running the same compressors
+// one by one. The loops are plain C++ rather than juce::dsp::SIMDRegister,
+// which stops at 256-bit AVX and has no exp2, so the FastMath gain stage
+// vectorises too and AVX-512 builds get the full 16 lanes.
+//
+// Audio is planar per channel, so each chunk is transposed into lane order
+// on the way in and back on the way out.
+//
+// A lane is the single band kernel's core: input gain, peak detection, the
+// attack/release filter, the soft-knee curve and makeup gain, with the
+// unlinked, linked-max and linked-average modes. With constant gains the
+// output is the same as CompressorKernel's with those settings. Gain changes
+// are smoothed by a one-pole filter rather than the kernel's ramp, so they
+// stay a lane-wise step.
+struct CompressorBankBase
+{
+    struct Parameters
+    {
+        float inputGainDb = 0.0f;
+        float makeupGainDb = 0.0f;
+        float thresholdDb = 0.0f;
+        float ratio = 1.0f;
+        float attackMs = 1.0f;
+        float releaseMs = 100.0f;
+        float kneeDb = 0.0f;
+        CompressorKernelBase::LinkMode link = CompressorKernelBase::LinkMode::unlinked; // mid/side runs unlinked
+    };
+};
+
+template <typename SampleType>
+class CompressorBank : public CompressorBankBase
+{
+public:
+    // Sets the number of lanes; lanes kept from an earlier prepare() keep
+    // their settings and new ones start with the defaults. Unlike the
+    // kernel's, a bank's settings are made per lane, after this.
+    void prepare(double newSampleRate, int numCompressors, int channelsPerCompressor)
+    {
+        sampleRate = newSampleRate;
+        numLanes = juce::jmax(1, numCompressors);
+        numChannels = juce::jmax(1, channelsPerCompressor);
+
+        // Rows are padded to a whole number of the widest registers.
+        stride = (numLanes + laneAlignment - 1) / laneAlignment * laneAlignment;
+
+        for (auto* row : { &thresholdLog2s, &slopes, &kneeWidths, &kneeFactors, &attackCoefficients, &releaseCoefficients,
+                           &inputGainTargets, &makeupGainTargets, &inputGains, &makeupGains, &linked, &averaged,
+                           &linkMax, &linkSum, &gains })
+            row->assign((size_t)stride, SampleType());
+
+        envelopes.assign((size_t)(numChannels * stride), SampleType());
+        samples.assign((size_t)(numChannels * chunkSize * stride), SampleType());
+        params.resize((size_t)numLanes);
+
+        smoothing = (SampleType)(1.0 - std::exp(-1.0 / (CompressorKernelBase::gainRampSeconds * sampleRate)));
+
+        for (int lane = 0; lane < numLanes; ++lane)
+            updateLane(lane);
+
+        reset();
+    }
+
+    // Clears the envelopes and jumps the gains to their targets, so settings
+    // made between prepare() and reset() apply from the first sample.
+    void reset() noexcept
+    {
+        std::fill(envelopes.begin(), envelopes.end(), SampleType());
+        inputGains = inputGainTargets;
+        makeupGains = makeupGainTargets;
+    }
+
+    int getNumCompressors() const noexcept { return numLanes; }
+    int getChannelsPerCompressor() const noexcept { return numChannels; }
+
+    // After prepare(), for index below getNumCompressors(). Recomputes the
+    // lane's coefficients only if something changed, so calling it every
+    // block is cheap.
+    void setParameters(int index, const Parameters& newParameters) noexcept
+    {
+        jassert(juce::isPositiveAndBelow(index, numLanes));
+
+        if (! juce::isPositiveAndBelow(index, numLanes))
+            return;
+
+        auto& p = params[(size_t)index];
+        auto& q = newParameters;
+
+        if (p.inputGainDb == q.inputGainDb && p.makeupGainDb == q.makeupGainDb && p.thresholdDb == q.thresholdDb
+            && p.ratio == q.ratio && p.attackMs == q.attackMs && p.releaseMs == q.releaseMs && p.kneeDb == q.kneeDb
+            && p.link == q.link)
+            return;
+
+        p = q;
+        updateLane(index);
+    }
+
+    // Compressor c's channel ch is channels[c * getChannelsPerCompressor() + ch].
+    void process(SampleType* const* channels, int numSamples) noexcept
+    {
+        auto laneCount = numLanes;
+        auto inverseNumChannels = (SampleType)1 / (SampleType)numChannels;
+
+        for (int start = 0; start < numSamples; start += chunkSize)
+        {
+            auto n = juce::jmin(chunkSize, numSamples - start);
+
+            // Row by row, so the writes are contiguous and the reads walk
+            // each compressor's channel a sample at a time.
+            for (int ch = 0; ch < numChannels; ++ch)
+                for (int i = 0; i < n; ++i)
+                {
+                    auto* dest = getRow(ch, i);
+
+                    for (int lane = 0; lane < laneCount; ++lane)
+                        dest[lane] = channels[lane * numChannels + ch][start + i];
+                }
+
+            for (int i = 0; i < n; ++i)
+            {
+                auto* inGain = inputGains.data();
+                auto* outGain = makeupGains.data();
+                auto* inTarget = inputGainTargets.data();
+                auto* outTarget = makeupGainTargets.data();
+
+                for (int lane = 0; lane < laneCount; ++lane)
+                {
+                    inGain[lane] += (inTarget[lane] - inGain[lane]) * smoothing;
+                    outGain[lane] += (outTarget[lane] - outGain[lane]) * smoothing;
+                }
+
+                // Input gain, then the linked level of every lane, whether
+                // or not it is linked: a select is cheaper than a branch.
+                auto* maxLevel = linkMax.data();
+                auto* sumLevel = linkSum.data();
+
+                for (int ch = 0; ch < numChannels; ++ch)
+                {
+                    auto* x = getRow(ch, i);
+
+                    for (int lane = 0; lane < laneCount; ++lane)
+                    {
+                        x[lane] *= inGain[lane];
+                        auto level = std::abs(x[lane]);
+                        maxLevel[lane] = ch == 0 ? level : juce::jmax(maxLevel[lane], level);
+                        sumLevel[lane] = ch == 0 ? level : sumLevel[lane] + level;
+                    }
+                }
+
+                // Selects are 0/1 blends, which are exact and keep the loops
+                // free of branches.
+                auto* isAveraged = averaged.data();
+
+                for (int lane = 0; lane < laneCount; ++lane)
+                    maxLevel[lane] = isAveraged[lane] * (sumLevel[lane] * inverseNumChannels)
+                                   + ((SampleType)1 - isAveraged[lane]) * maxLevel[lane];
+
+                auto* isLinked = linked.data();
+                auto* attack = attackCoefficients.data();
+                auto* release = releaseCoefficients.data();
+                auto* threshold = thresholdLog2s.data();
+                auto* slope = slopes.data();
+                auto* kneeWidth = kneeWidths.data();
+                auto* kneeFactor = kneeFactors.data();
+
+                for (int ch = 0; ch < numChannels; ++ch)
+                {
+                    auto* x = getRow(ch, i);
+                    auto* env = envelopes.data() + (size_t)(ch * stride);
+                    auto* g = gains.data();
+
+                    for (int lane = 0; lane < laneCount; ++lane)
+                    {
+                        auto level = isLinked[lane] * maxLevel[lane] + ((SampleType)1 - isLinked[lane]) * std::abs(x[lane]);
+                        auto rising = (SampleType)(level > env[lane]);
+                        auto cte = rising * attack[lane] + ((SampleType)1 - rising) * release[lane];
+                        env[lane] = level + cte * (env[lane] - level);
+                    }
+
+                    // Separate loops keep the arrays each one touches few
+                    // enough for the compiler's aliasing checks.
+                    for (int lane = 0; lane < laneCount; ++lane)
+                        g[lane] = GainComputer<SampleType>::getGain(env[lane], threshold[lane], slope[lane], kneeWidth[lane], kneeFactor[lane]);
+
+                    for (int lane = 0; lane < laneCount; ++lane)
+                        x[lane] = x[lane] * g[lane] * outGain[lane];
+                }
+            }
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                for (int i = 0; i < n; ++i)
+                {
+                    auto* source = getRow(ch, i);
+
+                    for (int lane = 0; lane < laneCount; ++lane)
+                        channels[lane * numChannels + ch][start + i] = source[lane];
+                }
+        }
+    }
+
+private:
+    // An AVX-512 register's worth of lanes.
+    static constexpr int laneAlignment = 64 / (int)sizeof(SampleType);
+
+    // Small enough that a chunk of 2 channels of 256 lanes stays in L2.
+    static constexpr int chunkSize = 32;
+
+    SampleType* getRow(int channel, int sample) noexcept
+    {
+        return samples.data() + (size_t)((channel * chunkSize + sample) * stride);
+    }
+
+    void updateLane(int lane) noexcept
+    {
+        auto& p = params[(size_t)lane];
+        auto expFactor = -2.0 * juce::MathConstants<double>::pi * 1000.0 / sampleRate;
+        auto coefficient = [expFactor](float timeMs) { return timeMs < 1.0e-3f ? SampleType() : (SampleType)std::exp(expFactor / timeMs); };
+
+        GainComputer<SampleType> curve;
+        curve.setParameters(p.thresholdDb, p.ratio, p.kneeDb);
+        thresholdLog2s[(size_t)lane] = curve.thresholdLog2;
+        slopes[(size_t)lane] = curve.slope;
+        kneeWidths[(size_t)lane] = curve.kneeWidth;
+        kneeFactors[(size_t)lane] = curve.kneeFactor;
+        attackCoefficients[(size_t)lane] = coefficient(p.attackMs);
+        releaseCoefficients[(size_t)lane] = coefficient(p.releaseMs);
+        inputGainTargets[(size_t)lane] = juce::Decibels::decibelsToGain((SampleType)p.inputGainDb);
+        makeupGainTargets[(size_t)lane] = juce::Decibels::decibelsToGain((SampleType)p.makeupGainDb);
+
+        using LinkMode = CompressorKernelBase::LinkMode;
+        auto isLinked = numChannels > 1 && (p.link == LinkMode::linkedMax || p.link == LinkMode::linkedAverage);
+        linked[(size_t)lane] = isLinked ? (SampleType)1 : SampleType();
+        averaged[(size_t)lane] = isLinked && p.link == LinkMode::linkedAverage ? (SampleType)1 : SampleType();
+    }
+
+    double sampleRate = 44100.0;
+    int numLanes = 0, numChannels = 1, stride = 0;
+    SampleType smoothing = 1;
+    std::vector<Parameters> params;
+
+    // One entry per lane, padded to 'stride'.
+    std::vector<SampleType> thresholdLog2s, slopes, kneeWidths, kneeFactors;
+    std::vector<SampleType> attackCoefficients, releaseCoefficients;
+    std::vector<SampleType> inputGainTargets, makeupGainTargets, inputGains, makeupGains;
+    std::vector<SampleType> linked, averaged; // 0 or 1
+    std::vector<SampleType> linkMax, linkSum, gains;
+
+    // [channel][lane], and the chunk as [channel][sample][lane].
+    std::vector<SampleType> envelopes;
+    std::vector<SampleType> samples;
+};
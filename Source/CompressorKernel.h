@@ -0,0 +1,638 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "GainReductionFifo.h"
+#include "GainComputer.h"
+#include "LevelDetector.h"
+#include "AutoBallistics.h"
+#include "SilenceGate.h"
+
+// Fused compressor kernel. Input gain, level detection, ballistics, the gain
+// computer, makeup gain and level metering all run while a chunk of the
+// channel is hot in L1, instead of one full pass over the buffer per stage.
+// The ballistics match juce::dsp::Compressor's BallisticsFilter; the detector
+// (LevelDetector) and the soft-knee gain computer (GainComputer) are our own.
+// Auto attack and release swap the ballistics for AutoBallistics.
+// With lookahead the detector sees each sample before it reaches the gain
+// stage, through a delay line allocated in prepare().
+//
+// Templated on the sample type so the host's double-precision buffers are
+// processed as they are. Everything that does not depend on it lives in
+// CompressorKernelBase, so the parameter snapshot and the link modes are the
+// same type for both.
+struct CompressorKernelBase
+{
+    // How the channels share detection. Linked modes fold every channel's
+    // level into one (loudest, or mean) and apply one gain to all of them.
+    // Mid/side runs unlinked on the mid and side of channels 0 and 1, which
+    // are front left and right in every JUCE layout; any other channels are
+    // unlinked as usual.
+    enum class LinkMode
+    {
+        unlinked,
+        linkedMax,
+        linkedAverage,
+        midSide
+    };
+
+    // One block's worth of parameter values, in the units the user sees.
+    struct Parameters
+    {
+        float inputGainDb = 0.0f;
+        float makeupGainDb = 0.0f;
+        float thresholdDb = 0.0f;
+        float ratio = 1.0f;
+        float attackMs = 1.0f;
+        float releaseMs = 100.0f;
+        bool autoAttack = false;
+        bool autoRelease = false;
+        float lookaheadMs = 0.0f;
+        float kneeDb = 0.0f;
+        LevelDetectorBase::Mode detector = LevelDetectorBase::Mode::peak;
+        float rmsWindowMs = 10.0f;
+        LinkMode link = LinkMode::unlinked;
+    };
+
+    static constexpr float maxLookaheadMs = 20.0f;
+    static constexpr double gainRampSeconds = 0.05;
+
+    template <typename SampleType>
+    static SampleType toRMS(SampleType sumOfSquares, int numSamples) noexcept
+    {
+        return numSamples > 0 ? std::sqrt(sumOfSquares / (SampleType)numSamples) : SampleType();
+    }
+};
+
+template <typename SampleType>
+class CompressorKernel : public CompressorKernelBase
+{
+public:
+    // Sums of squares over all channels, taken after the input gain, after
+    // the gain computer and after the makeup gain.
+    struct Levels
+    {
+        SampleType input = 0;
+        SampleType compressed = 0;
+        SampleType output = 0;
+    };
+
+    // The kernel may run inside an oversampler, at baseSampleRate times any
+    // factor up to maxOversamplingFactor; see setOversamplingFactor().
+    void prepare(double baseSampleRate, int maxChannels, int maxOversamplingFactor = 1)
+    {
+        baseRate = baseSampleRate;
+        envelope.assign((size_t)juce::jmax(1, maxChannels), SampleType());
+        autoStates.assign(envelope.size(), AutoState{});
+        chunks.assign(envelope.size(), ChannelChunk{});
+        frame.assign(envelope.size(), SampleType());
+        channelGains.assign(envelope.size(), (SampleType)1);
+        detector.prepare(baseRate * juce::jmax(1, maxOversamplingFactor), maxChannels);
+        detector.setMode(params.detector);
+        detector.setRmsWindow(params.rmsWindowMs);
+
+        // All delay memory is claimed here, for the longest lookahead at the
+        // highest rate, so changing the lookahead or the oversampling factor
+        // later only moves the read position.
+        auto maxDelay = (int)std::ceil(maxLookaheadMs * 0.001 * baseRate) * juce::jmax(1, maxOversamplingFactor);
+        delayCapacity = juce::nextPowerOfTwo(maxDelay + chunkSize);
+        delayLine.assign(envelope.size() * (size_t)delayCapacity, SampleType());
+        delayWritePosition = 0;
+        delaySamples = 0;
+
+        setOversamplingFactor(1);
+        inputGain.setCurrentAndTargetValue(juce::Decibels::decibelsToGain((SampleType)params.inputGainDb));
+        makeupGain.setCurrentAndTargetValue(juce::Decibels::decibelsToGain((SampleType)params.makeupGainDb));
+        gainComputer.setParameters(params.thresholdDb, params.ratio, params.kneeDb);
+    }
+
+    // Rate-dependent state is recomputed without allocating. The envelopes are
+    // kept, so only the lookahead delay content jumps when the factor changes.
+    void setOversamplingFactor(int factor) noexcept
+    {
+        oversamplingFactor = juce::jmax(1, factor);
+        sampleRate = baseRate * oversamplingFactor;
+
+        for (auto* smoother : { &inputGain, &makeupGain })
+            smoother->reset(sampleRate, gainRampSeconds);
+
+        attackCoefficient = calculateCoefficient(params.attackMs);
+        releaseCoefficient = calculateCoefficient(params.releaseMs);
+        updateAutoCoefficients();
+        detector.setSampleRate(sampleRate);
+        updateDelay();
+    }
+
+    void reset()
+    {
+        std::fill(envelope.begin(), envelope.end(), SampleType());
+        std::fill(autoStates.begin(), autoStates.end(), AutoState{});
+        std::fill(delayLine.begin(), delayLine.end(), SampleType());
+        detector.reset();
+        silenceGate.reset();
+    }
+
+    // Per-sample gains, as the smallest across channels, are pushed here when
+    // set. The meter sees each gain when it is computed, so with lookahead it
+    // leads the audio it applies to.
+    void setGainMeter(GainReductionFifo* meter) noexcept { gainMeter = meter; }
+
+    // Samples at the base rate by which the audio lags the detector.
+    int getLatencySamples() const noexcept { return delaySamples / oversamplingFactor; }
+
+    // Only the derived values whose inputs changed are recomputed, so calling
+    // this every block with an unchanged snapshot is just a few compares.
+    void setParameters(const Parameters& newParameters) noexcept
+    {
+        if (newParameters.inputGainDb != params.inputGainDb)
+            inputGain.setTargetValue(juce::Decibels::decibelsToGain((SampleType)newParameters.inputGainDb));
+
+        if (newParameters.makeupGainDb != params.makeupGainDb)
+            makeupGain.setTargetValue(juce::Decibels::decibelsToGain((SampleType)newParameters.makeupGainDb));
+
+        auto curveChanged = newParameters.thresholdDb != params.thresholdDb || newParameters.ratio != params.ratio
+                            || newParameters.kneeDb != params.kneeDb;
+        auto attackChanged = newParameters.attackMs != params.attackMs;
+        auto releaseChanged = newParameters.releaseMs != params.releaseMs;
+        auto lookaheadChanged = newParameters.lookaheadMs != params.lookaheadMs;
+        auto autoChanged = newParameters.autoAttack != params.autoAttack || newParameters.autoRelease != params.autoRelease;
+        auto wasAutomatic = isAutomatic();
+
+        params = newParameters;
+
+        if (curveChanged)
+            gainComputer.setParameters(params.thresholdDb, params.ratio, params.kneeDb);
+
+        if (attackChanged)
+            attackCoefficient = calculateCoefficient(params.attackMs);
+
+        if (releaseChanged)
+            releaseCoefficient = calculateCoefficient(params.releaseMs);
+
+        if (attackChanged || releaseChanged || autoChanged)
+            updateAutoCoefficients();
+
+        if (isAutomatic() && ! wasAutomatic)
+            for (size_t ch = 0; ch < envelope.size(); ++ch)
+                autoStates[ch] = Auto::fromEnvelope(envelope[ch]);
+
+        if (lookaheadChanged)
+            updateDelay();
+
+        detector.setMode(params.detector);
+        detector.setRmsWindow(params.rmsWindowMs);
+    }
+
+    // Silence fast path, called before process() on the same base-rate block
+    // (before any oversampling). Returns false when the block has to be
+    // processed. Otherwise the block is zeroed and only the gain ramps and
+    // the meter advance; the detector, envelopes and delay line are left as
+    // they are. That only happens once every envelope has released below the
+    // floor and the delay line holds nothing but silence, so processing picks
+    // up where it would have been anyway. 'settleSamples' is any further
+    // base-rate delay of the caller's, such as an oversampler's.
+    bool processSilence(SampleType* const* channels, int numChannels, int numSamples,
+                        const SampleType* const* key = nullptr, int settleSamples = 0) noexcept
+    {
+        numChannels = juce::jmin(numChannels, (int)envelope.size());
+
+        auto inGain = juce::jmax(inputGain.getCurrentValue(), inputGain.getTargetValue());
+        auto outGain = juce::jmax(makeupGain.getCurrentValue(), makeupGain.getTargetValue());
+        auto peak = SilenceGate::getPeak(channels, numChannels, numSamples) * inGain * outGain;
+
+        // A loud key would move the envelopes, so it has to be silent too.
+        if (key != nullptr)
+            peak = juce::jmax(peak, SilenceGate::getPeak(key, numChannels, numSamples) * inGain);
+
+        settleSamples += (delaySamples + oversamplingFactor - 1) / oversamplingFactor;
+
+        if (! silenceGate.update((double)peak, numSamples, settleSamples))
+            return false;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto env = envelope[(size_t)ch];
+
+            if (isAutomatic())
+                env = juce::jmax(env, autoStates[(size_t)ch].slow);
+
+            if (env >= (SampleType)SilenceGate::floor)
+                return false;
+        }
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            juce::FloatVectorOperations::clear(channels[ch], numSamples);
+
+        auto numProcessed = numSamples * oversamplingFactor;
+        inputGain.skip(numProcessed);
+        makeupGain.skip(numProcessed);
+
+        if (isAutomatic())
+            for (int ch = 0; ch < numChannels; ++ch)
+                Auto::skip(autoStates[(size_t)ch], autoCoefficients.crest, numProcessed);
+
+        if (gainMeter != nullptr && numChannels > 0)
+            gainMeter->pushConstant(1.0f, numProcessed);
+
+        return true;
+    }
+
+    // Vectorised path. Falls back to the scalar reference when juce_dsp has
+    // no SIMD support for the target.
+    //
+    // Each chunk is done in two passes over the channels: input gain and
+    // detection, then delay and gain. In between, linked modes fold the
+    // channels' levels into one, so the ballistics and gain computer run
+    // once per frame. The per-channel chunks are planar scratch, so every
+    // pass is a straight run of SIMD lanes over samples.
+    //
+    // If key is given, the detector follows it instead of the audio. One key
+    // channel per audio channel, at the base rate when oversampled (each key
+    // sample is held for oversamplingFactor audio samples). The input gain
+    // applies to the key as well, so it shifts detection either way.
+    Levels process(SampleType* const* channels, int numChannels, int numSamples,
+                   const SampleType* const* key = nullptr) noexcept
+    {
+       #if JUCE_USE_SIMD
+        Levels levels;
+        numChannels = juce::jmin(numChannels, (int)envelope.size());
+
+        auto midSide = isMidSide(numChannels);
+        auto linked = isLinked(numChannels);
+        auto inverseNumChannels = (SampleType)1 / (SampleType)juce::jmax(1, numChannels);
+
+        if (midSide)
+            encodeMidSide(channels[0], channels[1], numSamples);
+
+        auto inAcc = Vec::expand(0), compAcc = Vec::expand(0), outAcc = Vec::expand(0);
+
+        for (int start = 0; start < numSamples; start += chunkSize)
+        {
+            auto n = juce::jmin(chunkSize, numSamples - start);
+            auto padded = (n + (int)lanes - 1) & ~((int)lanes - 1);
+
+            fillGains(inputGain, inGains, n, padded);
+            fillGains(makeupGain, outGains, n, padded);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto* data = channels[ch] + start;
+                auto* x = chunks[(size_t)ch].samples;
+                auto* level = chunks[(size_t)ch].gains;
+
+                std::copy(data, data + n, x);
+                std::fill(x + n, x + padded, SampleType());
+
+                for (int i = 0; i < padded; i += (int)lanes)
+                {
+                    auto v = Vec::fromRawArray(x + i) * Vec::fromRawArray(inGains + i);
+                    inAcc += v * v;
+                    v.copyToRawArray(x + i);
+                }
+
+                const SampleType* detectorInput = x;
+
+                if (key != nullptr)
+                {
+                    for (int i = 0; i < n; ++i)
+                        level[i] = key[ch][(start + i) / oversamplingFactor] * inGains[i];
+
+                    detectorInput = level;
+                }
+
+                // Detection and the ballistics filter are recursions, so
+                // they stay scalar; the gain computer after them vectorises.
+                detector.process(ch, detectorInput, level, n);
+                std::fill(level + n, level + padded, SampleType());
+
+                if (linked)
+                {
+                    if (ch == 0)
+                        std::copy(level, level + padded, gain);
+                    else if (params.link == LinkMode::linkedMax)
+                        for (int i = 0; i < padded; i += (int)lanes)
+                            Vec::max(Vec::fromRawArray(gain + i), Vec::fromRawArray(level + i)).copyToRawArray(gain + i);
+                    else
+                        for (int i = 0; i < padded; i += (int)lanes)
+                            (Vec::fromRawArray(gain + i) + Vec::fromRawArray(level + i)).copyToRawArray(gain + i);
+                }
+                else
+                {
+                    computeGains((size_t)ch, level, n, padded);
+
+                    if (gainMeter != nullptr)
+                    {
+                        if (ch == 0)
+                            std::copy(level, level + padded, frameGains);
+                        else
+                            for (int i = 0; i < padded; i += (int)lanes)
+                                Vec::min(Vec::fromRawArray(frameGains + i), Vec::fromRawArray(level + i)).copyToRawArray(frameGains + i);
+                    }
+                }
+            }
+
+            if (linked)
+            {
+                if (params.link == LinkMode::linkedAverage)
+                    for (int i = 0; i < padded; i += (int)lanes)
+                        (Vec::fromRawArray(gain + i) * inverseNumChannels).copyToRawArray(gain + i);
+
+                computeGains(0, gain, n, padded);
+            }
+
+            if (gainMeter != nullptr && numChannels > 0)
+                gainMeter->push(linked ? gain : frameGains, n);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto* data = channels[ch] + start;
+                auto* x = chunks[(size_t)ch].samples;
+                auto* g = linked ? gain : chunks[(size_t)ch].gains;
+
+                if (delaySamples > 0)
+                    applyDelay(ch, x, n);
+
+                for (int i = 0; i < padded; i += (int)lanes)
+                {
+                    auto v = Vec::fromRawArray(x + i) * Vec::fromRawArray(g + i);
+                    compAcc += v * v;
+                    v = v * Vec::fromRawArray(outGains + i);
+                    outAcc += v * v;
+                    v.copyToRawArray(x + i);
+                }
+
+                std::copy(x, x + n, data);
+            }
+
+            delayWritePosition = (delayWritePosition + n) & (delayCapacity - 1);
+        }
+
+        if (midSide)
+            decodeMidSide(channels[0], channels[1], numSamples);
+
+        levels.input = inAcc.sum();
+        levels.compressed = compAcc.sum();
+        levels.output = outAcc.sum();
+        return levels;
+       #else
+        return processScalar(channels, numChannels, numSamples, key);
+       #endif
+    }
+
+    // Straightforward per-frame reference. Audio output is bit-identical to
+    // process(); the level sums differ only by summation order.
+    Levels processScalar(SampleType* const* channels, int numChannels, int numSamples,
+                         const SampleType* const* key = nullptr) noexcept
+    {
+        Levels levels;
+        numChannels = juce::jmin(numChannels, (int)envelope.size());
+
+        auto midSide = isMidSide(numChannels);
+        auto linked = isLinked(numChannels);
+        auto inverseNumChannels = (SampleType)1 / (SampleType)juce::jmax(1, numChannels);
+
+        if (midSide)
+            encodeMidSide(channels[0], channels[1], numSamples);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto inGain = inputGain.getNextValue();
+            auto outGain = makeupGain.getNextValue();
+            auto frameGain = (SampleType)1;
+            auto linkLevel = SampleType();
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto sample = channels[ch][i] * inGain;
+                levels.input += sample * sample;
+                frame[(size_t)ch] = sample;
+
+                auto detectorInput = key != nullptr ? key[ch][i / oversamplingFactor] * inGain : sample;
+                auto level = SampleType();
+                detector.process(ch, &detectorInput, &level, 1);
+
+                if (! linked)
+                    channelGains[(size_t)ch] = gainComputer.getGain(follow((size_t)ch, level));
+                else if (ch == 0)
+                    linkLevel = level;
+                else
+                    linkLevel = params.link == LinkMode::linkedMax ? juce::jmax(linkLevel, level) : linkLevel + level;
+            }
+
+            if (linked)
+            {
+                if (params.link == LinkMode::linkedAverage)
+                    linkLevel *= inverseNumChannels;
+
+                frameGain = gainComputer.getGain(follow(0, linkLevel));
+            }
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto sample = frame[(size_t)ch];
+                auto gainValue = linked ? frameGain : channelGains[(size_t)ch];
+
+                if (! linked)
+                    frameGain = ch == 0 ? gainValue : juce::jmin(frameGain, gainValue);
+
+                if (delaySamples > 0)
+                {
+                    auto* line = delayLine.data() + (size_t)ch * (size_t)delayCapacity;
+                    line[delayWritePosition] = sample;
+                    sample = line[(delayWritePosition - delaySamples) & (delayCapacity - 1)];
+                }
+
+                sample *= gainValue;
+                levels.compressed += sample * sample;
+
+                sample *= outGain;
+                channels[ch][i] = sample;
+                levels.output += sample * sample;
+            }
+
+            if (gainMeter != nullptr && numChannels > 0)
+                gainMeter->push(&frameGain, 1);
+
+            delayWritePosition = (delayWritePosition + 1) & (delayCapacity - 1);
+        }
+
+        if (midSide)
+            decodeMidSide(channels[0], channels[1], numSamples);
+
+        return levels;
+    }
+
+    using GainSmoother = juce::SmoothedValue<SampleType, juce::ValueSmoothingTypes::Multiplicative>;
+
+    // Writes the next n values of a gain ramp, zero-padded to 'padded'. A
+    // settled smoother is a plain fill.
+    static void fillGains(GainSmoother& smoother, SampleType* dest, int n, int padded) noexcept
+    {
+        if (smoother.isSmoothing())
+        {
+            for (int i = 0; i < n; ++i)
+                dest[i] = smoother.getNextValue();
+
+            std::fill(dest + n, dest + padded, SampleType());
+        }
+        else
+        {
+            std::fill(dest, dest + padded, smoother.getTargetValue());
+        }
+    }
+
+private:
+
+    // Writes a chunk of detector-aligned samples into the channel's delay line
+    // and replaces it with the chunk delaySamples behind it.
+    void applyDelay(int channel, SampleType* chunk, int n) noexcept
+    {
+        auto* line = delayLine.data() + (size_t)channel * (size_t)delayCapacity;
+        auto mask = delayCapacity - 1;
+
+        for (int i = 0; i < n; ++i)
+        {
+            auto writeIndex = (delayWritePosition + i) & mask;
+            line[writeIndex] = chunk[i];
+            chunk[i] = line[(writeIndex - delaySamples) & mask];
+        }
+    }
+
+    bool isMidSide(int numChannels) const noexcept { return params.link == LinkMode::midSide && numChannels >= 2; }
+
+    bool isLinked(int numChannels) const noexcept
+    {
+        return numChannels > 1 && (params.link == LinkMode::linkedMax || params.link == LinkMode::linkedAverage);
+    }
+
+    static void encodeMidSide(SampleType* left, SampleType* right, int numSamples) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto mid = (left[i] + right[i]) * (SampleType)0.5;
+            auto side = (left[i] - right[i]) * (SampleType)0.5;
+            left[i] = mid;
+            right[i] = side;
+        }
+    }
+
+    static void decodeMidSide(SampleType* mid, SampleType* side, int numSamples) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto left = mid[i] + side[i];
+            auto right = mid[i] - side[i];
+            mid[i] = left;
+            side[i] = right;
+        }
+    }
+
+    // Levels to gains in place: ballistics, then the gain computer. The tail
+    // up to 'padded' is zeroed so it adds nothing to the level sums.
+    void computeGains(size_t channel, SampleType* values, int n, int padded) noexcept
+    {
+        auto& env = envelope[channel];
+
+        if (isAutomatic())
+        {
+            auto& state = autoStates[channel];
+
+            for (int i = 0; i < n; ++i)
+                values[i] = Auto::process(values[i], env, state, autoCoefficients);
+        }
+        else
+        {
+            for (int i = 0; i < n; ++i)
+                values[i] = followEnvelope(env, values[i]);
+        }
+
+        gainComputer.process(values, n);
+        std::fill(values + n, values + padded, SampleType());
+    }
+
+    // One sample of computeGains()'s ballistics, for the scalar reference.
+    SampleType follow(size_t channel, SampleType level) noexcept
+    {
+        return isAutomatic() ? Auto::process(level, envelope[channel], autoStates[channel], autoCoefficients)
+                             : followEnvelope(envelope[channel], level);
+    }
+
+    SampleType followEnvelope(SampleType& env, SampleType level) const noexcept
+    {
+        auto cte = level > env ? attackCoefficient : releaseCoefficient;
+        env = level + cte * (env - level);
+        return env;
+    }
+
+    bool isAutomatic() const noexcept { return params.autoAttack || params.autoRelease; }
+
+    void updateAutoCoefficients() noexcept
+    {
+        autoCoefficients = Auto::makeCoefficients(sampleRate, params.attackMs, params.releaseMs,
+                                                  params.autoAttack, params.autoRelease);
+    }
+
+    SampleType calculateCoefficient(float timeMs) const noexcept
+    {
+        auto expFactor = -2.0 * juce::MathConstants<double>::pi * 1000.0 / sampleRate;
+        return timeMs < 1.0e-3f ? SampleType() : (SampleType)std::exp(expFactor / timeMs);
+    }
+
+    void updateDelay() noexcept
+    {
+        // Whole base-rate samples, so the latency reported to the host is exact.
+        auto wanted = (int)std::round(juce::jlimit(0.0f, maxLookaheadMs, params.lookaheadMs) * 0.001 * baseRate) * oversamplingFactor;
+        wanted = juce::jmin(wanted, delayCapacity - chunkSize);
+
+        // The line is not written while the lookahead is off, so it holds
+        // stale audio when it is switched back on.
+        if (delaySamples == 0 && wanted > 0)
+            std::fill(delayLine.begin(), delayLine.end(), SampleType());
+
+        delaySamples = wanted;
+    }
+
+   #if JUCE_USE_SIMD
+    using Vec = juce::dsp::SIMDRegister<SampleType>;
+    static constexpr size_t lanes = Vec::SIMDNumElements;
+    static constexpr size_t simdAlignment = Vec::SIMDRegisterSize; // 32 bytes under AVX
+   #else
+    static constexpr size_t lanes = 1;
+    static constexpr size_t simdAlignment = 16;
+   #endif
+
+    static constexpr int chunkSize = 64;
+
+    using Auto = AutoBallistics<SampleType>;
+    using AutoState = typename Auto::State;
+
+    struct alignas(simdAlignment) ChannelChunk
+    {
+        SampleType samples[chunkSize];
+        SampleType gains[chunkSize];
+    };
+
+    std::vector<ChannelChunk> chunks;
+    std::vector<SampleType> frame, channelGains;
+
+    alignas(simdAlignment) SampleType gain[chunkSize];
+    alignas(simdAlignment) SampleType inGains[chunkSize];
+    alignas(simdAlignment) SampleType outGains[chunkSize];
+    alignas(simdAlignment) SampleType frameGains[chunkSize];
+
+    GainReductionFifo* gainMeter = nullptr;
+    Parameters params;
+    std::vector<SampleType> envelope;
+    std::vector<AutoState> autoStates;
+    std::vector<SampleType> delayLine;
+    int delayCapacity = chunkSize, delayWritePosition = 0, delaySamples = 0;
+    double baseRate = 44100.0, sampleRate = 44100.0;
+    int oversamplingFactor = 1;
+
+    GainSmoother inputGain{ 1 }, makeupGain{ 1 };
+
+    LevelDetector<SampleType> detector;
+    GainComputer<SampleType> gainComputer;
+    SilenceGate silenceGate;
+    SampleType attackCoefficient = 0, releaseCoefficient = 0;
+    typename Auto::Coefficients autoCoefficients;
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+#if ONECOMP_PROCESS_STATS
+
+// The processBlock() timing of one instance, refreshed four times a second.
+// Opened from the Help menu with Shift held.
+class DiagnosticsPage : public juce::Component, private juce::Timer
+{
+public:
+    explicit DiagnosticsPage(OneCompAudioProcessor& p)
+        : processor(p)
+    {
+        resetButton.onClick = [this]
+        {
+            processor.resetProcessStats();
+            stats = {};
+            repaint();
+        };
+
+        addAndMakeVisible(resetButton);
+        setSize(440, 230);
+        timerCallback();
+        startTimerHz(4);
+    }
+
+    void paint(juce::Graphics& g) override
+    {
+        g.fillAll(getLookAndFeel().findColour(juce::ResizableWindow::backgroundColourId));
+        g.setColour(getLookAndFeel().findColour(juce::Label::textColourId));
+        g.setFont(juce::Font(juce::Font::getDefaultMonospacedFontName(), 14.0f, juce::Font::plain));
+
+        auto us = [](double value) { return juce::String(value, 1) + " us"; };
+        auto percent = [](double value) { return juce::String(value * 100.0, 2) + " %"; };
+
+        const std::pair<const char*, juce::String> rows[] = {
+            { "Blocks", juce::String((juce::int64)stats.numBlocks) },
+            { "Samples", juce::String((juce::int64)stats.numSamples) },
+            { "Block time", "min " + us(stats.minUs) + ", mean " + us(stats.meanUs) },
+            { "", "p99 " + us(stats.p99Us) + ", max " + us(stats.maxUs) },
+            { "Load", percent(stats.load) + " of real time" },
+            { "Worst block", percent(stats.worstBlockLoad) + " of its length" },
+            { "Overruns", juce::String((juce::int64)stats.numOverruns) },
+        };
+
+        auto area = getLocalBounds().reduced(12);
+        area.removeFromBottom(resetButton.getHeight());
+
+        for (auto& row : rows)
+        {
+            auto line = area.removeFromTop(22);
+            g.drawText(row.first, line.removeFromLeft(120), juce::Justification::centredLeft);
+            g.drawText(row.second, line, juce::Justification::centredLeft);
+        }
+    }
+
+    void resized() override
+    {
+        resetButton.setBounds(getLocalBounds().reduced(12).removeFromBottom(26).removeFromRight(90));
+    }
+
+private:
+    void timerCallback() override
+    {
+        stats = processor.getProcessStats();
+        repaint();
+    }
+
+    OneCompAudioProcessor& processor;
+    ProcessStats::Snapshot stats;
+    juce::TextButton resetButton{ "Reset" };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DiagnosticsPage)
+};
+
+#endif
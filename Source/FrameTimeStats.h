@@ -0,0 +1,87 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Message-thread time spent by the editor, split into painting and timer
+// work. Components wrap their paint() in a Scope; the editor reports the
+// totals once per reporting period. Only touched on the message thread.
+class FrameTimeStats
+{
+public:
+    enum Stage
+    {
+        paint,
+        timer,
+        numStages
+    };
+
+    class Scope
+    {
+    public:
+        Scope(FrameTimeStats* s, Stage st) noexcept
+            : stats(s), stage(st), start(s != nullptr ? juce::Time::getHighResolutionTicks() : 0)
+        {
+        }
+
+        ~Scope()
+        {
+            if (stats != nullptr)
+                stats->add(stage, juce::Time::getHighResolutionTicks() - start);
+        }
+
+    private:
+        FrameTimeStats* stats;
+        Stage stage;
+        juce::int64 start;
+
+        JUCE_DECLARE_NON_COPYABLE(Scope)
+    };
+
+    void add(Stage stage, juce::int64 ticks) noexcept
+    {
+        auto& s = stages[(size_t)stage];
+        auto ms = juce::Time::highResolutionTicksToSeconds(ticks) * 1000.0;
+        ++s.count;
+        s.totalMs += ms;
+        s.maxMs = juce::jmax(s.maxMs, ms);
+    }
+
+    // Returns a summary once per 'periodMs' and starts a new period;
+    // returns an empty string in between.
+    juce::String takeSummary(juce::uint32 periodMs = 2000)
+    {
+        auto now = juce::Time::getMillisecondCounter();
+
+        if (periodStart == 0)
+            periodStart = now;
+
+        if (now - periodStart < periodMs)
+            return {};
+
+        auto seconds = (double)(now - periodStart) * 0.001;
+        juce::String summary;
+
+        for (size_t i = 0; i < stages.size(); ++i)
+        {
+            auto& s = stages[i];
+            summary << (i == (size_t)paint ? "paint " : ", timer ")
+                    << juce::String(s.totalMs / seconds, 2) << " ms/s over " << juce::String(s.count / seconds, 1)
+                    << " calls/s, max " << juce::String(s.maxMs, 2) << " ms";
+            s = {};
+        }
+
+        periodStart = now;
+        return summary;
+    }
+
+private:
+    struct StageTotals
+    {
+        int count = 0;
+        double totalMs = 0.0;
+        double maxMs = 0.0;
+    };
+
+    std::array<StageTotals, numStages> stages;
+    juce::uint32 periodStart = 0;
+};
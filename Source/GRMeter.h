@@ -1,37 +1,206 @@
 ﻿#pragma once
 
 #include <JuceHeader.h>
-#include "PluginProcessor.h"
+#include "GainReductionFifo.h"
+#include "FrameTimeStats.h"
 
-class GainReductionMeter : public juce::Component, private juce::Timer {
+// Gain reduction meter fed with points drained from the processor's
+// GainReductionFifo by the editor's timer. Shows the deepest reduction of the
+// last frame as a bar, a peak hold marker and a history trace.
+//
+// The trace sweeps left to right across a cached image, like a scope, with a
+// short gap ahead of the newest point, so new points overwrite the oldest in
+// place instead of scrolling the whole trace. Each frame draws only the new
+// points into the image and repaints only the columns they cover and the
+// span between the old and new bar and peak positions; an idle meter costs
+// nothing.
+class GainReductionMeter : public juce::Component {
 public:
-    GainReductionMeter(OneCompAudioProcessor& p) : audioProcessor(p) {
-        startTimerHz(30); 
-        reductionLabel.setText("-∞ dB", juce::dontSendNotification); 
-        reductionLabel.setFont(juce::Font(15.0f)); 
-        reductionLabel.setColour(juce::Label::textColourId, juce::Colours::white); 
-        reductionLabel.setJustificationType(juce::Justification::centredRight); 
+    static constexpr float rangeDb = -20.0f;
+    static constexpr int historySize = 512;
+    static constexpr juce::uint32 peakHoldMs = 1500;
+
+    GainReductionMeter() {
+        setOpaque(true);
+        history.fill(0.0f);
+        reductionLabel.setText("0.00 dB", juce::dontSendNotification);
+        reductionLabel.setFont(juce::Font(15.0f));
+        reductionLabel.setColour(juce::Label::textColourId, juce::Colours::white);
+        reductionLabel.setJustificationType(juce::Justification::centredRight);
         addAndMakeVisible(reductionLabel);
     }
 
+    void setFrameStats(FrameTimeStats* stats) { frameStats = stats; }
+
+    // Called once per UI frame, possibly with no points when the audio is
+    // stopped; the meter then holds its last reading.
+    void addPoints(const GainReductionFifo::Point* points, int numPoints) {
+        if (numPoints <= 0)
+            return;
+
+        auto deepest = 0.0f;
+        auto historyWasActive = numActivePoints > 0;
+        auto first = historyIndex;
+
+        for (int i = 0; i < numPoints; ++i) {
+            auto reductionDb = juce::Decibels::gainToDecibels(points[i].minGain, rangeDb * 3.0f);
+            auto& slot = history[(size_t)historyIndex];
+            numActivePoints += (reductionDb < 0.0f ? 1 : 0) - (slot < 0.0f ? 1 : 0);
+            slot = reductionDb;
+            historyIndex = (historyIndex + 1) % historySize;
+            deepest = juce::jmin(deepest, reductionDb);
+        }
+
+        auto oldBarX = getX(currentReduction);
+        auto oldPeakX = getX(peakReduction);
+
+        currentReduction = deepest;
+        auto now = juce::Time::getMillisecondCounter();
+
+        if (deepest <= peakReduction || now >= peakHoldUntil) {
+            peakReduction = deepest;
+            peakHoldUntil = now + peakHoldMs;
+        }
+
+        reductionLabel.setText(juce::String(currentReduction, 2) + " dB", juce::dontSendNotification);
+
+        // Points without reduction draw nothing, so once the trace has none
+        // left it stays blank and is not drawn at all.
+        if ((historyWasActive || numActivePoints > 0) && trace.isValid()) {
+            if (numPoints >= historySize) {
+                redrawTrace();
+                repaint();
+                return;
+            }
+
+            juce::Graphics g(trace);
+
+            for (int i = 0; i < numPoints; ++i)
+                drawPoint(g, (first + i) % historySize);
+
+            clearGap(g);
+            repaintColumns(getTraceX(first), getTraceX(historyIndex) + gapWidth + 1);
+        }
+
+        auto left = juce::jmin(oldBarX, getX(currentReduction), oldPeakX, getX(peakReduction));
+        auto right = juce::jmax(oldBarX, getX(currentReduction), oldPeakX, getX(peakReduction));
+
+        if (right > left)
+            repaint(left - 1, 0, right - left + 2, getHeight());
+    }
+
+    float getCurrentReduction() const { return currentReduction; }
+    float getPeakReduction() const { return peakReduction; }
+
     void paint(juce::Graphics& g) override {
+        FrameTimeStats::Scope scope(frameStats, FrameTimeStats::paint);
+
         auto area = getLocalBounds().toFloat();
-        float reduction = audioProcessor.getGainReduction();
-        float width = juce::jmap(reduction, 0.f, -20.f, 0.f, area.getWidth());
+        g.drawImageAt(trace, 0, 0);
 
-        g.fillAll(juce::Colours::black);
+        juce::Rectangle<float> meterRect = area.withLeft((float)getX(currentReduction));
         g.setColour(juce::Colours::green);
         g.fillRect(meterRect);
-        juce::Rectangle<float> meterRect = area.removeFromRight(width);
+
+        g.setColour(juce::Colours::yellow);
+        g.drawVerticalLine(getX(peakReduction), area.getY(), area.getBottom());
     }
 
-    void timerCallback() override {
-        float reductionDb = audioProcessor.getGainReduction();
-        reductionLabel.setText(juce::String(reductionDb, 2) + " dB", juce::dontSendNotification);
-        repaint();
+    void resized() override {
+        reductionLabel.setBounds(getLocalBounds().removeFromLeft(80));
+        trace = juce::Image(juce::Image::RGB, juce::jmax(1, getWidth()), juce::jmax(1, getHeight()), true);
+        redrawTrace();
     }
 
 private:
-    OneCompAudioProcessor& audioProcessor;
+    static constexpr int gapWidth = 4;
+
+    // Bars grow leftwards from the right edge.
+    int getX(float reductionDb) const {
+        auto width = (float)getWidth();
+        return juce::roundToInt(width - juce::jmap(juce::jlimit(rangeDb, 0.0f, reductionDb), 0.0f, rangeDb, 0.0f, width));
+    }
+
+    // History slot 'index' always sits at the same place on the trace.
+    int getTraceX(int index) const {
+        return index * trace.getWidth() / historySize;
+    }
+
+    int getTraceY(float reductionDb) const {
+        return juce::roundToInt(juce::jmap(juce::jlimit(rangeDb, 0.0f, reductionDb), 0.0f, rangeDb, 0.0f, (float)(trace.getHeight() - 1)));
+    }
+
+    // Clears the point's columns, unless it shares them with the point before,
+    // and joins it to that point.
+    void drawPoint(juce::Graphics& g, int index) {
+        auto x = getTraceX(index);
+        auto right = juce::jmax(x + 1, getTraceX(index + 1));
+
+        if (index == 0 || x != getTraceX(index - 1)) {
+            g.setColour(juce::Colours::black);
+            g.fillRect(x, 0, right - x, trace.getHeight());
+        }
+
+        auto previous = history[(size_t)((index + historySize - 1) % historySize)];
+        auto current = history[(size_t)index];
+
+        if (previous < 0.0f || current < 0.0f) {
+            auto y0 = getTraceY(previous);
+            auto y1 = getTraceY(current);
+            g.setColour(traceColour);
+            g.fillRect(x, juce::jmin(y0, y1), 1, std::abs(y1 - y0) + 1);
+            g.fillRect(x, y1, right - x, 1);
+        }
+    }
+
+    // Starts past the newest point's column, which the next point may share.
+    void clearGap(juce::Graphics& g) {
+        auto x = getTraceX(historyIndex);
+
+        if (historyIndex > 0 && x == getTraceX(historyIndex - 1))
+            ++x;
+
+        g.setColour(juce::Colours::black);
+        g.fillRect(x, 0, gapWidth, trace.getHeight());
+        g.fillRect(x - trace.getWidth(), 0, gapWidth, trace.getHeight());
+    }
+
+    void redrawTrace() {
+        juce::Graphics g(trace);
+        g.fillAll(juce::Colours::black);
+
+        for (int i = 0; i < historySize; ++i)
+            drawPoint(g, (historyIndex + i) % historySize);
+
+        clearGap(g);
+        repaint();
+    }
+
+    // Columns [fromX, toX) of the trace, wrapping at its right edge.
+    void repaintColumns(int fromX, int toX) {
+        auto width = trace.getWidth();
+
+        if (toX <= fromX)
+            toX += width;
+
+        repaint(fromX, 0, toX - fromX, getHeight());
+
+        if (toX > width)
+            repaint(0, 0, toX - width, getHeight());
+    }
+
+    // Translucent green over the black background, made opaque for the RGB image.
+    const juce::Colour traceColour = juce::Colours::black.interpolatedWith(juce::Colours::green, 0.4f);
+
     juce::Label reductionLabel;
+    FrameTimeStats* frameStats = nullptr;
+
+    juce::Image trace;
+    std::array<float, historySize> history;
+    int historyIndex = 0;
+    int numActivePoints = 0;
+
+    float currentReduction = 0.0f;
+    float peakReduction = 0.0f;
+    juce::uint32 peakHoldUntil = 0;
 };
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Polynomial log2/exp2 for the gain computer. Both split the number into
+// exponent and mantissa and fit the mantissa with a polynomial that is exact
+// at the ends of the octave, so the result is continuous across octaves.
+//
+// Error bounds, measured over the full range the detector produces:
+//   log2: absolute error below 1.2e-4 (0.0007 dB)
+//   exp2: relative error below 5e-6 (0.00004 dB)
+// so a gain computed as exp2(slope * log2(x)) with |slope| <= 1 is within
+// 0.001 dB of std::pow. The double versions use the same polynomials and
+// so have the same bounds. Both are plain arithmetic on the bit pattern and
+// vectorise when called in a loop.
+namespace FastMath
+{
+    template <typename FloatType>
+    struct Bits;
+
+    template <>
+    struct Bits<float>
+    {
+        using Integer = juce::uint32;
+        static constexpr int mantissaBits = 23;
+        static constexpr int bias = 127;
+        static constexpr Integer mantissaMask = 0x007fffffu;
+        static constexpr Integer one = 0x3f800000u;
+    };
+
+    template <>
+    struct Bits<double>
+    {
+        using Integer = juce::uint64;
+        static constexpr int mantissaBits = 52;
+        static constexpr int bias = 1023;
+        static constexpr Integer mantissaMask = 0x000fffffffffffffull;
+        static constexpr Integer one = 0x3ff0000000000000ull;
+    };
+
+    template <typename FloatType>
+    inline FloatType log2(FloatType x) noexcept
+    {
+        // Inputs are levels: non-negative and finite. Zero maps to -bias.
+        using B = Bits<FloatType>;
+        typename B::Integer bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+
+        auto exponent = (FloatType)((int)(bits >> B::mantissaBits) - B::bias);
+        bits = (bits & B::mantissaMask) | B::one;
+
+        FloatType mantissa;
+        std::memcpy(&mantissa, &bits, sizeof(mantissa));
+
+        auto t = mantissa - (FloatType)1;
+        return exponent + t + t * ((FloatType)1 - t)
+                                  * ((FloatType)0.43872573 + t * ((FloatType)-0.2390582 + t * (FloatType)0.08213066));
+    }
+
+    template <typename FloatType>
+    inline FloatType exp2(FloatType x) noexcept
+    {
+        using B = Bits<FloatType>;
+        constexpr auto limit = (FloatType)(B::bias - 1);
+        x = juce::jlimit(-limit, limit, x);
+
+        auto whole = (int)x;
+        whole -= x < (FloatType)whole ? 1 : 0;
+        auto f = x - (FloatType)whole;
+
+        auto result = (FloatType)1 + f + f * (f - (FloatType)1)
+                                             * ((FloatType)0.30696788 + f * ((FloatType)0.06558812 + f * (FloatType)0.013555747));
+
+        typename B::Integer bits;
+        std::memcpy(&bits, &result, sizeof(bits));
+        bits += (typename B::Integer)whole << B::mantissaBits;
+        std::memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+}
+
+// Static curve from detector envelope to gain, in the log2 domain. A knee of
+// width W centred on the threshold blends quadratically from unity into the
+// ratio slope; with W = 0 it is the hard knee of juce::dsp::Compressor.
+template <typename SampleType>
+struct GainComputer
+{
+    static constexpr float maxKneeDb = 24.0f;
+
+    void setParameters(float thresholdDb, float ratio, float kneeDb) noexcept
+    {
+        // log2 units per dB.
+        constexpr auto perDb = (SampleType)1 / (SampleType)6.0205999132796239;
+
+        thresholdLog2 = (SampleType)juce::jmax(-200.0f, thresholdDb) * perDb;
+        slope = (SampleType)1 / (SampleType)juce::jmax(1.0f, ratio) - (SampleType)1;
+        kneeWidth = (SampleType)juce::jlimit(0.0f, maxKneeDb, kneeDb) * perDb;
+        kneeFactor = kneeWidth > 0 ? slope / ((SampleType)2 * kneeWidth) : (SampleType)0;
+    }
+
+    SampleType getGain(SampleType envelope) const noexcept
+    {
+        return getGain(envelope, thresholdLog2, slope, kneeWidth, kneeFactor);
+    }
+
+    // Branch-free: below the knee both terms are zero, inside it only the
+    // quadratic term is non-zero, and above it the two add up to slope * over.
+    // Static so that callers holding the curve values per lane can loop over
+    // them directly.
+    static SampleType getGain(SampleType envelope, SampleType thresholdLog2, SampleType slope,
+                              SampleType kneeWidth, SampleType kneeFactor) noexcept
+    {
+        auto above = FastMath::log2(envelope) - thresholdLog2 + (SampleType)0.5 * kneeWidth;
+        auto inKnee = juce::jlimit((SampleType)0, kneeWidth, above);
+        auto pastKnee = juce::jmax((SampleType)0, above - kneeWidth);
+
+        return FastMath::exp2(kneeFactor * inKnee * inKnee + slope * pastKnee);
+    }
+
+    // In place, envelopes to gains.
+    void process(SampleType* values, int numValues) const noexcept
+    {
+        for (int i = 0; i < numValues; ++i)
+            values[i] = getGain(values[i]);
+    }
+
+    SampleType thresholdLog2 = 0;
+    SampleType slope = 0;
+    SampleType kneeWidth = 0;
+    SampleType kneeFactor = 0;
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "WaveformHistory.h"
+
+// Carries the gain computer's output from the audio thread to the editor.
+// The audio thread pushes every per-sample gain (already reduced to the
+// smallest gain across channels) and the FIFO decimates them into points
+// holding the min and max gain over samplesPerPoint samples. One writer and
+// one reader, no locks; when the reader falls behind, new points are dropped.
+// Every point also goes to the WaveformHistory, if one is set, whether or not
+// it fits in the FIFO; the history drops them while no display is showing.
+class GainReductionFifo
+{
+public:
+    struct Point
+    {
+        float minGain = 1.0f; // deepest reduction in the span
+        float maxGain = 1.0f; // shallowest reduction in the span
+    };
+
+    // Base-rate samples per point. At 48 kHz this is 1500 points per second,
+    // about 50 per 30 Hz UI frame.
+    static constexpr int defaultSamplesPerPoint = 32;
+    static constexpr int capacity = 4096;
+
+    // Not while the audio thread is pushing.
+    void setWaveformHistory(WaveformHistory* newHistory) noexcept { history = newHistory; }
+
+    // Audio thread only. Gains pushed at an oversampled rate need a
+    // proportionally larger span to keep points the same length in time.
+    void setSamplesPerPoint(int numSamples) noexcept
+    {
+        samplesPerPoint = juce::jmax(1, numSamples);
+        pointCount = juce::jmin(pointCount, samplesPerPoint - 1);
+    }
+
+    // Audio thread only. Double-precision gains are narrowed to the float
+    // points the meter draws.
+    template <typename SampleType>
+    void push(const SampleType* gains, int numSamples) noexcept
+    {
+        for (int i = 0; i < numSamples;)
+        {
+            auto run = juce::jmin(numSamples - i, samplesPerPoint - pointCount);
+
+            for (int j = i; j < i + run; ++j)
+            {
+                pending.minGain = juce::jmin(pending.minGain, (float)gains[j]);
+                pending.maxGain = juce::jmax(pending.maxGain, (float)gains[j]);
+            }
+
+            i += run;
+            advance(run);
+        }
+    }
+
+    // Audio thread only. For spans where no gain is computed, such as
+    // skipped silence or bypass.
+    void pushConstant(float gain, int numSamples) noexcept
+    {
+        for (int i = 0; i < numSamples;)
+        {
+            auto run = juce::jmin(numSamples - i, samplesPerPoint - pointCount);
+            pending.minGain = juce::jmin(pending.minGain, gain);
+            pending.maxGain = juce::jmax(pending.maxGain, gain);
+
+            i += run;
+            advance(run);
+        }
+    }
+
+    // Message thread only. Returns the number of points copied.
+    int pop(Point* dest, int maxPoints) noexcept
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(maxPoints, start1, size1, start2, size2);
+
+        std::copy(points.begin() + start1, points.begin() + start1 + size1, dest);
+        std::copy(points.begin() + start2, points.begin() + start2 + size2, dest + size1);
+
+        fifo.finishedRead(size1 + size2);
+        return size1 + size2;
+    }
+
+private:
+    void advance(int numSamples) noexcept
+    {
+        pointCount += numSamples;
+
+        if (pointCount == samplesPerPoint)
+        {
+            if (history != nullptr)
+                history->addGainPoint(pending.minGain);
+
+            write(pending);
+            pending = { 1.0f, 0.0f };
+            pointCount = 0;
+        }
+    }
+
+    void write(const Point& point) noexcept
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+        if (size1 > 0)
+            points[(size_t)start1] = point;
+
+        fifo.finishedWrite(size1);
+    }
+
+    juce::AbstractFifo fifo{ capacity };
+    std::array<Point, capacity> points;
+
+    Point pending{ 1.0f, 0.0f };
+    int pointCount = 0;
+    int samplesPerPoint = defaultSamplesPerPoint;
+    WaveformHistory* history = nullptr;
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Filters the detector key. High-pass and low-pass are TPT state variable
+// filters; the tilt is a first order split at tiltPivotHz with the low and
+// high halves scaled in opposite directions. A stage at its neutral setting
+// is skipped, and with all three neutral the key is not filtered at all.
+struct KeyFilterBase
+{
+    struct Parameters
+    {
+        float highPassHz = minFrequency;
+        float lowPassHz = maxFrequency;
+        float tiltDb = 0.0f;
+    };
+
+    static constexpr float minFrequency = 20.0f;
+    static constexpr float maxFrequency = 20000.0f;
+    static constexpr float maxTiltDb = 6.0f;
+    static constexpr float tiltPivotHz = 1000.0f;
+};
+
+template <typename SampleType>
+class KeyFilter : public KeyFilterBase
+{
+public:
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        sampleRate = spec.sampleRate;
+
+        highPass.setType(juce::dsp::StateVariableTPTFilterType::highpass);
+        lowPass.setType(juce::dsp::StateVariableTPTFilterType::lowpass);
+        tilt.setType(juce::dsp::FirstOrderTPTFilterType::lowpass);
+
+        highPass.prepare(spec);
+        lowPass.prepare(spec);
+        tilt.prepare(spec);
+        tilt.setCutoffFrequency((SampleType)tiltPivotHz);
+
+        update();
+    }
+
+    void reset()
+    {
+        highPass.reset();
+        lowPass.reset();
+        tilt.reset();
+    }
+
+    void setParameters(const Parameters& newParameters) noexcept
+    {
+        if (newParameters.highPassHz == params.highPassHz
+            && newParameters.lowPassHz == params.lowPassHz
+            && newParameters.tiltDb == params.tiltDb)
+            return;
+
+        params = newParameters;
+        update();
+    }
+
+    bool isActive() const noexcept { return highPassOn || lowPassOn || tiltOn; }
+
+    void process(int channel, const SampleType* input, SampleType* output, int numSamples) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto x = input[i];
+
+            if (highPassOn)
+                x = highPass.processSample(channel, x);
+
+            if (lowPassOn)
+                x = lowPass.processSample(channel, x);
+
+            if (tiltOn)
+            {
+                auto low = tilt.processSample(channel, x);
+                x = low * tiltLowGain + (x - low) * tiltHighGain;
+            }
+
+            output[i] = x;
+        }
+    }
+
+private:
+    void update() noexcept
+    {
+        auto nyquistLimit = (float)sampleRate * 0.45f;
+
+        highPassOn = params.highPassHz > minFrequency;
+        lowPassOn = params.lowPassHz < juce::jmin(maxFrequency, nyquistLimit);
+        tiltOn = params.tiltDb != 0.0f;
+
+        if (highPassOn)
+            highPass.setCutoffFrequency((SampleType)juce::jmin(params.highPassHz, nyquistLimit));
+
+        if (lowPassOn)
+            lowPass.setCutoffFrequency((SampleType)params.lowPassHz);
+
+        auto tiltDb = juce::jlimit(-maxTiltDb, maxTiltDb, params.tiltDb);
+        tiltLowGain = juce::Decibels::decibelsToGain((SampleType)(-0.5f * tiltDb));
+        tiltHighGain = juce::Decibels::decibelsToGain((SampleType)(0.5f * tiltDb));
+    }
+
+    Parameters params;
+    double sampleRate = 44100.0;
+
+    juce::dsp::StateVariableTPTFilter<SampleType> highPass, lowPass;
+    juce::dsp::FirstOrderTPTFilter<SampleType> tilt;
+
+    bool highPassOn = false, lowPassOn = false, tiltOn = false;
+    SampleType tiltLowGain = 1, tiltHighGain = 1;
+};
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Turns the detector input into the level the ballistics follow.
+//   peak:      |x|
+//   rms:       root mean square over a sliding window, kept as a running sum
+//              of squares over a ring, so O(1) per sample at any window length
+//   truePeak:  the largest |x| among the sample and three interpolated points
+//              between it and the previous one (4x polyphase FIR, as in
+//              ITU-R BS.1770), which catches inter-sample overs. The filter
+//              delays the detector by about six samples.
+// All memory is claimed in prepare(); rate and window changes only re-zero it.
+struct LevelDetectorBase
+{
+    enum class Mode
+    {
+        peak,
+        rms,
+        truePeak
+    };
+
+    static constexpr float minRmsWindowMs = 1.0f;
+    static constexpr float maxRmsWindowMs = 50.0f;
+};
+
+template <typename SampleType>
+class LevelDetector : public LevelDetectorBase
+{
+public:
+    LevelDetector()
+    {
+        // Hann-windowed sinc prototype at 4x, cut off a little below the
+        // original Nyquist. Each phase is normalised to unity DC gain.
+        constexpr auto length = numPhases * tapsPerPhase;
+        constexpr auto centre = (length - 1) * 0.5;
+        constexpr auto cutoff = 0.9 / numPhases;
+
+        std::array<double, numPhases> sums{};
+
+        for (int k = 0; k < length; ++k)
+        {
+            auto t = k - centre;
+            auto sinc = std::sin(juce::MathConstants<double>::pi * cutoff * t) / (juce::MathConstants<double>::pi * cutoff * t);
+            auto window = 0.5 - 0.5 * std::cos(juce::MathConstants<double>::twoPi * (k + 0.5) / length);
+            auto value = sinc * window;
+
+            taps[(size_t)(k / numPhases)][(size_t)(k % numPhases)] = (SampleType)value;
+            sums[(size_t)(k % numPhases)] += value;
+        }
+
+        for (auto& tap : taps)
+            for (int phase = 0; phase < numPhases; ++phase)
+                tap[(size_t)phase] = (SampleType)(tap[(size_t)phase] / sums[(size_t)phase]);
+    }
+
+    void prepare(double maxSampleRate, int maxChannels)
+    {
+        ringCapacity = (int)std::ceil(maxRmsWindowMs * 0.001 * maxSampleRate) + 1;
+        channels.assign((size_t)juce::jmax(1, maxChannels), ChannelState{});
+        ring.assign(channels.size() * (size_t)ringCapacity, SampleType());
+        setSampleRate(maxSampleRate);
+    }
+
+    void setSampleRate(double newSampleRate) noexcept
+    {
+        sampleRate = newSampleRate;
+        updateWindow();
+    }
+
+    void setMode(Mode newMode) noexcept
+    {
+        if (newMode != mode)
+        {
+            mode = newMode;
+            reset();
+        }
+    }
+
+    void setRmsWindow(float windowMs) noexcept
+    {
+        if (windowMs != rmsWindowMs)
+        {
+            rmsWindowMs = windowMs;
+            updateWindow();
+        }
+    }
+
+    Mode getMode() const noexcept { return mode; }
+
+    void reset() noexcept
+    {
+        std::fill(channels.begin(), channels.end(), ChannelState{});
+        std::fill(ring.begin(), ring.end(), SampleType());
+    }
+
+    // Input and output may be the same buffer.
+    void process(int channel, const SampleType* input, SampleType* levels, int numSamples) noexcept
+    {
+        auto& state = channels[(size_t)channel];
+
+        switch (mode)
+        {
+            case Mode::peak:
+                for (int i = 0; i < numSamples; ++i)
+                    levels[i] = std::abs(input[i]);
+                break;
+
+            case Mode::rms:
+            {
+                auto* squares = ring.data() + (size_t)channel * (size_t)ringCapacity;
+                auto scale = 1.0 / windowLength;
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    auto square = input[i] * input[i];
+                    state.sum += (double)square - (double)squares[state.position];
+                    squares[state.position] = square;
+                    state.position = state.position + 1 == windowLength ? 0 : state.position + 1;
+
+                    levels[i] = (SampleType)std::sqrt(juce::jmax(0.0, state.sum * scale));
+                }
+                break;
+            }
+
+            case Mode::truePeak:
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    // The history is stored twice so the taps read one
+                    // contiguous run, newest first.
+                    state.position = state.position == 0 ? tapsPerPhase - 1 : state.position - 1;
+                    state.history[(size_t)state.position] = state.history[(size_t)(state.position + tapsPerPhase)] = input[i];
+
+                    std::array<SampleType, numPhases> phases{};
+                    auto* recent = state.history.data() + state.position;
+
+                    for (int j = 0; j < tapsPerPhase; ++j)
+                        for (int phase = 0; phase < numPhases; ++phase)
+                            phases[(size_t)phase] += taps[(size_t)j][(size_t)phase] * recent[j];
+
+                    auto level = SampleType();
+
+                    for (auto value : phases)
+                        level = juce::jmax(level, std::abs(value));
+
+                    levels[i] = level;
+                }
+                break;
+        }
+    }
+
+private:
+    static constexpr int numPhases = 4;
+    static constexpr int tapsPerPhase = 12;
+
+    void updateWindow() noexcept
+    {
+        auto wanted = (int)std::round(juce::jlimit(minRmsWindowMs, maxRmsWindowMs, rmsWindowMs) * 0.001 * sampleRate);
+        wanted = juce::jlimit(1, juce::jmax(1, ringCapacity), wanted);
+
+        if (wanted != windowLength)
+        {
+            windowLength = wanted;
+            reset();
+        }
+    }
+
+    struct ChannelState
+    {
+        double sum = 0.0;
+        int position = 0;
+        std::array<SampleType, 2 * tapsPerPhase> history{};
+    };
+
+    Mode mode = Mode::peak;
+    float rmsWindowMs = 10.0f;
+    double sampleRate = 44100.0;
+    int windowLength = 1;
+    int ringCapacity = 0;
+
+    std::vector<ChannelState> channels;
+    std::vector<SampleType> ring;
+    std::array<std::array<SampleType, numPhases>, tapsPerPhase> taps;
+};
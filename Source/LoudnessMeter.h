@@ -0,0 +1,460 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "LevelDetector.h"
+
+// Loudness as ITU-R BS.1770-4 and EBU R128 define it, measured as the audio
+// streams through:
+//   momentary:   the last 400 ms
+//   short-term:  the last 3 s
+//   integrated:  everything since the last reset, gated at -70 LUFS and then
+//                10 LU below the mean of what passed
+//   range:       the spread of the short-term values, 95th less 10th
+//                percentile, after gates of -70 LUFS and 20 LU below their
+//                mean (EBU Tech 3342)
+//   true peak:   the largest 4x oversampled sample, from LevelDetector
+//
+// The K-weighted power is summed over 100 ms steps. Momentary and short-term
+// are the last 4 and 30 step sums, and every momentary and short-term value
+// goes into a histogram of 0.1 LU bins holding a count and an energy sum. The
+// gates and the percentiles are then found from the histograms, so each step
+// costs the same however long the measurement has run, and nothing is
+// allocated after prepare(). Gating is exact to the bin: a bin counts when
+// its centre passes the relative gate, as in libebur128's histogram mode.
+struct LoudnessMeterBase
+{
+    // Reported for anything not measured yet or below the absolute gate.
+    static constexpr float minLoudness = -100.0f;
+    static constexpr double absoluteGate = -70.0;
+
+    struct Snapshot
+    {
+        float momentary = minLoudness;  // LUFS
+        float shortTerm = minLoudness;  // LUFS
+        float integrated = minLoudness; // LUFS
+        float range = 0.0f;             // LU
+        float truePeak = minLoudness;   // dBTP
+    };
+
+    // Weights for the channels of 'layout': 0 for LFE, 1.41 for the
+    // surrounds and 1 for the rest, as BS.1770 gives them.
+    static std::vector<double> getChannelWeights(const juce::AudioChannelSet& layout, int numChannels)
+    {
+        std::vector<double> weights((size_t)numChannels, 1.0);
+
+        for (int ch = 0; ch < numChannels && ch < layout.size(); ++ch)
+        {
+            switch (layout.getTypeOfChannel(ch))
+            {
+                case juce::AudioChannelSet::LFE:
+                case juce::AudioChannelSet::LFE2:
+                    weights[(size_t)ch] = 0.0;
+                    break;
+
+                case juce::AudioChannelSet::leftSurround:
+                case juce::AudioChannelSet::rightSurround:
+                case juce::AudioChannelSet::leftSurroundSide:
+                case juce::AudioChannelSet::rightSurroundSide:
+                case juce::AudioChannelSet::leftSurroundRear:
+                case juce::AudioChannelSet::rightSurroundRear:
+                    weights[(size_t)ch] = 1.41;
+                    break;
+
+                default:
+                    break;
+            }
+        }
+
+        return weights;
+    }
+
+protected:
+    static constexpr int stepsPerMomentary = 4;
+    static constexpr int stepsPerShortTerm = 30;
+    static constexpr double lowestBin = absoluteGate;
+    static constexpr int binsPerLU = 10;
+    static constexpr int numBins = 100 * binsPerLU; // up to +30 LUFS
+
+    static double toLoudness(double meanSquare) noexcept
+    {
+        return meanSquare > 0.0 ? -0.691 + 10.0 * std::log10(meanSquare) : -std::numeric_limits<double>::infinity();
+    }
+
+    static int getBin(double loudness) noexcept
+    {
+        return juce::jlimit(0, numBins - 1, (int)((loudness - lowestBin) * binsPerLU));
+    }
+
+    static double getBinCentre(int bin) noexcept
+    {
+        return lowestBin + (bin + 0.5) / binsPerLU;
+    }
+
+    // Counts and energy sums of gated blocks, by loudness.
+    struct Histogram
+    {
+        std::array<juce::uint32, numBins> counts{};
+        std::array<double, numBins> energies{};
+        juce::uint64 total = 0;
+        double totalEnergy = 0.0;
+
+        void clear() noexcept
+        {
+            counts.fill(0);
+            energies.fill(0.0);
+            total = 0;
+            totalEnergy = 0.0;
+        }
+
+        // Blocks at or below the absolute gate are left out.
+        void add(double meanSquare) noexcept
+        {
+            auto loudness = toLoudness(meanSquare);
+
+            if (loudness <= absoluteGate)
+                return;
+
+            auto bin = getBin(loudness);
+            ++counts[(size_t)bin];
+            energies[(size_t)bin] += meanSquare;
+            ++total;
+            totalEnergy += meanSquare;
+        }
+
+        // The first bin whose centre is at or above 'offset' LU relative to
+        // the mean of everything added.
+        int getRelativeGateBin(double offset) const noexcept
+        {
+            auto gate = toLoudness(totalEnergy / (double)total) + offset;
+
+            if (gate < lowestBin)
+                return 0;
+
+            auto bin = getBin(gate);
+            return getBinCentre(bin) < gate ? bin + 1 : bin;
+        }
+    };
+};
+
+template <typename SampleType>
+class LoudnessMeter : public LoudnessMeterBase
+{
+public:
+    // 'weights' has one entry per channel; see getChannelWeights().
+    void prepare(double newSampleRate, const std::vector<double>& weights, bool measureTruePeak = true)
+    {
+        sampleRate = newSampleRate;
+        channelWeights = weights;
+        filters.assign(weights.size(), Filter{});
+        samplesPerStep = juce::jmax(1, juce::roundToInt(sampleRate * 0.1));
+        truePeakEnabled = measureTruePeak;
+
+        if (truePeakEnabled)
+        {
+            truePeakDetector.setMode(LevelDetectorBase::Mode::truePeak);
+            truePeakDetector.prepare(sampleRate, (int)weights.size());
+        }
+
+        updateCoefficients();
+        clear();
+    }
+
+    // Any thread. Takes effect at the start of the next process().
+    void reset() noexcept
+    {
+        resetRequested.store(true, std::memory_order_release);
+    }
+
+    // Audio thread only. The same as reset(), at once.
+    void clear() noexcept
+    {
+        std::fill(filters.begin(), filters.end(), Filter{});
+        truePeakDetector.reset();
+        steps.fill(0.0);
+        numSteps = 0;
+        stepPosition = 0;
+        stepSum = 0.0;
+        shortTerm = minLoudness;
+        truePeak = 0.0;
+        momentaryHistogram.clear();
+        shortTermHistogram.clear();
+
+        for (auto* value : { &publishedMomentary, &publishedShortTerm, &publishedIntegrated, &publishedTruePeak })
+            value->store(minLoudness, std::memory_order_relaxed);
+
+        publishedRange.store(0.0f, std::memory_order_relaxed);
+    }
+
+    // Audio thread only. Measures samples [startSample, startSample +
+    // numSamples) of each channel.
+    void process(const SampleType* const* channels, int numChannels, int startSample, int numSamples) noexcept
+    {
+        if (resetRequested.load(std::memory_order_acquire))
+        {
+            resetRequested.store(false, std::memory_order_relaxed);
+            clear();
+        }
+
+        numChannels = juce::jmin(numChannels, (int)filters.size());
+
+        if (truePeakEnabled)
+            measureTruePeak(channels, numChannels, startSample, numSamples);
+
+        for (auto done = 0; done < numSamples;)
+        {
+            auto count = juce::jmin(numSamples - done, getSamplesUntilStep());
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                if (channelWeights[(size_t)ch] == 0.0)
+                    continue;
+
+                auto& filter = filters[(size_t)ch];
+                auto* input = channels[ch] + startSample + done;
+                auto sum = 0.0;
+
+                for (int i = 0; i < count; ++i)
+                {
+                    auto y = filter.process((double)input[i], shelf, highPass);
+                    sum += y * y;
+                }
+
+                stepSum += channelWeights[(size_t)ch] * sum;
+            }
+
+            done += count;
+            stepPosition += count;
+
+            if (stepPosition == samplesPerStep)
+                finishStep();
+        }
+    }
+
+    // Audio thread only: the samples left before the readings next change.
+    int getSamplesUntilStep() const noexcept { return samplesPerStep - stepPosition; }
+
+    // Audio thread only. The short-term loudness, or minLoudness before the
+    // first 3 s have been measured.
+    double getShortTermLoudness() const noexcept { return shortTerm; }
+
+    // Any thread.
+    Snapshot getSnapshot() const noexcept
+    {
+        if (resetRequested.load(std::memory_order_relaxed))
+            return {};
+
+        Snapshot s;
+        s.momentary = publishedMomentary.load(std::memory_order_relaxed);
+        s.shortTerm = publishedShortTerm.load(std::memory_order_relaxed);
+        s.integrated = publishedIntegrated.load(std::memory_order_relaxed);
+        s.range = publishedRange.load(std::memory_order_relaxed);
+        s.truePeak = publishedTruePeak.load(std::memory_order_relaxed);
+        return s;
+    }
+
+private:
+    struct Coefficients
+    {
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+    };
+
+    // The two K-weighting stages, a high shelf and a high pass, in
+    // transposed direct form II.
+    struct Filter
+    {
+        double s1 = 0.0, s2 = 0.0, t1 = 0.0, t2 = 0.0;
+
+        double process(double x, const Coefficients& a, const Coefficients& b) noexcept
+        {
+            auto y = a.b0 * x + s1;
+            s1 = a.b1 * x - a.a1 * y + s2;
+            s2 = a.b2 * x - a.a2 * y;
+
+            auto z = b.b0 * y + t1;
+            t1 = b.b1 * y - b.a1 * z + t2;
+            t2 = b.b2 * y - b.a2 * z;
+            return z;
+        }
+    };
+
+    // BS.1770 gives the coefficients at 48 kHz only; these are its analogue
+    // prototypes, which reproduce them there, bilinear-transformed to the
+    // rate in use.
+    void updateCoefficients() noexcept
+    {
+        {
+            constexpr auto f0 = 1681.974450955533, gainDb = 3.999843853973347, q = 0.7071752369554196;
+            auto k = std::tan(juce::MathConstants<double>::pi * f0 / sampleRate);
+            auto vh = std::pow(10.0, gainDb / 20.0);
+            auto vb = std::pow(vh, 0.4996667741545416);
+            auto a0 = 1.0 + k / q + k * k;
+
+            shelf.b0 = (vh + vb * k / q + k * k) / a0;
+            shelf.b1 = 2.0 * (k * k - vh) / a0;
+            shelf.b2 = (vh - vb * k / q + k * k) / a0;
+            shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+            shelf.a2 = (1.0 - k / q + k * k) / a0;
+        }
+
+        {
+            constexpr auto f0 = 38.13547087602444, q = 0.5003270373238773;
+            auto k = std::tan(juce::MathConstants<double>::pi * f0 / sampleRate);
+            auto a0 = 1.0 + k / q + k * k;
+
+            highPass.b0 = 1.0;
+            highPass.b1 = -2.0;
+            highPass.b2 = 1.0;
+            highPass.a1 = 2.0 * (k * k - 1.0) / a0;
+            highPass.a2 = (1.0 - k / q + k * k) / a0;
+        }
+    }
+
+    void measureTruePeak(const SampleType* const* channels, int numChannels, int startSample, int numSamples) noexcept
+    {
+        constexpr int chunkSize = 64;
+        SampleType levels[chunkSize];
+        auto peak = truePeak;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            for (int done = 0; done < numSamples; done += chunkSize)
+            {
+                auto count = juce::jmin(chunkSize, numSamples - done);
+                truePeakDetector.process(ch, channels[ch] + startSample + done, levels, count);
+
+                for (int i = 0; i < count; ++i)
+                    peak = juce::jmax(peak, (double)levels[i]);
+            }
+        }
+
+        if (peak > truePeak)
+        {
+            truePeak = peak;
+            publishedTruePeak.store(juce::Decibels::gainToDecibels((float)peak, minLoudness), std::memory_order_relaxed);
+        }
+    }
+
+    void finishStep() noexcept
+    {
+        steps[(size_t)(numSteps % stepsPerShortTerm)] = stepSum;
+        ++numSteps;
+        stepSum = 0.0;
+        stepPosition = 0;
+
+        if (numSteps >= stepsPerMomentary)
+        {
+            auto momentary = getMeanSquare(stepsPerMomentary);
+            momentaryHistogram.add(momentary);
+            publishedMomentary.store(toPublished(toLoudness(momentary)), std::memory_order_relaxed);
+            publishedIntegrated.store(toPublished(getIntegrated()), std::memory_order_relaxed);
+        }
+
+        if (numSteps >= stepsPerShortTerm)
+        {
+            auto meanSquare = getMeanSquare(stepsPerShortTerm);
+            shortTermHistogram.add(meanSquare);
+            shortTerm = toPublished(toLoudness(meanSquare));
+            publishedShortTerm.store((float)shortTerm, std::memory_order_relaxed);
+            publishedRange.store((float)getRange(), std::memory_order_relaxed);
+        }
+    }
+
+    // The mean weighted power of the last 'count' steps.
+    double getMeanSquare(int count) const noexcept
+    {
+        auto sum = 0.0;
+
+        for (int i = 1; i <= count; ++i)
+            sum += steps[(size_t)((numSteps - i) % stepsPerShortTerm)];
+
+        return sum / ((double)count * samplesPerStep);
+    }
+
+    double getIntegrated() const noexcept
+    {
+        auto& h = momentaryHistogram;
+
+        if (h.total == 0)
+            return minLoudness;
+
+        juce::uint64 count = 0;
+        auto energy = 0.0;
+
+        for (int bin = h.getRelativeGateBin(-10.0); bin < numBins; ++bin)
+        {
+            count += h.counts[(size_t)bin];
+            energy += h.energies[(size_t)bin];
+        }
+
+        return count > 0 ? toLoudness(energy / (double)count) : minLoudness;
+    }
+
+    double getRange() const noexcept
+    {
+        auto& h = shortTermHistogram;
+
+        if (h.total == 0)
+            return 0.0;
+
+        auto first = h.getRelativeGateBin(-20.0);
+        juce::uint64 count = 0;
+
+        for (int bin = first; bin < numBins; ++bin)
+            count += h.counts[(size_t)bin];
+
+        if (count == 0)
+            return 0.0;
+
+        auto low = getPercentileBin(first, count, 0.10);
+        auto high = getPercentileBin(first, count, 0.95);
+        return getBinCentre(high) - getBinCentre(low);
+    }
+
+    // The bin holding the value at 'fraction' of the way through the
+    // 'count' blocks from 'first' up.
+    int getPercentileBin(int first, juce::uint64 count, double fraction) const noexcept
+    {
+        auto rank = (juce::uint64)std::llround(fraction * (double)(count - 1));
+        juce::uint64 below = 0;
+
+        for (int bin = first; bin < numBins; ++bin)
+        {
+            below += shortTermHistogram.counts[(size_t)bin];
+
+            if (below > rank)
+                return bin;
+        }
+
+        return numBins - 1;
+    }
+
+    static float toPublished(double loudness) noexcept
+    {
+        return (float)juce::jmax((double)minLoudness, loudness);
+    }
+
+    double sampleRate = 48000.0;
+    int samplesPerStep = 4800;
+    bool truePeakEnabled = true;
+
+    Coefficients shelf, highPass;
+    std::vector<double> channelWeights;
+    std::vector<Filter> filters;
+    LevelDetector<SampleType> truePeakDetector;
+
+    // Audio thread only.
+    std::array<double, stepsPerShortTerm> steps{};
+    juce::uint64 numSteps = 0;
+    int stepPosition = 0;
+    double stepSum = 0.0;
+    double shortTerm = minLoudness;
+    double truePeak = 0.0;
+    Histogram momentaryHistogram, shortTermHistogram;
+
+    // Written by the audio thread once a step, read by anyone. Like
+    // ProcessStats, each is a relaxed store, so a reader may see one step's
+    // momentary value beside the previous step's integrated one.
+    std::atomic<float> publishedMomentary{ minLoudness }, publishedShortTerm{ minLoudness },
+                       publishedIntegrated{ minLoudness }, publishedRange{ 0.0f }, publishedTruePeak{ minLoudness };
+    std::atomic<bool> resetRequested{ false };
+};
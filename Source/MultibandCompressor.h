@@ -0,0 +1,447 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "CompressorKernel.h"
+
+// Two to four band compressor. The input is split by a cascade of
+// Linkwitz-Riley crossovers, with allpass compensation on the lower bands so
+// that the bands sum flat. The bands of each sample frame then sit in the
+// four lanes of an aligned array, so the detectors and gain stages of all
+// bands advance together in one vectorised pass rather than one pass per
+// band.
+struct MultibandCompressorBase
+{
+    static constexpr int maxBands = 4;
+
+    struct BandParameters
+    {
+        float thresholdDb = -20.0f;
+        float ratio = 3.0f;
+        float attackMs = 10.0f;
+        float releaseMs = 150.0f;
+        float makeupGainDb = 0.0f;
+    };
+
+    struct Parameters
+    {
+        int numBands = 3;
+        float inputGainDb = 0.0f;
+        float makeupGainDb = 0.0f;
+        float kneeDb = 0.0f;
+        bool autoAttack = false;
+        bool autoRelease = false;
+        std::array<float, maxBands - 1> crossoverHz{ { 120.0f, 1000.0f, 6000.0f } };
+        std::array<BandParameters, maxBands> bands;
+    };
+};
+
+template <typename SampleType>
+class MultibandCompressor : public MultibandCompressorBase
+{
+public:
+    using Kernel = CompressorKernel<SampleType>;
+
+    void prepare(double newSampleRate, int maxChannels)
+    {
+        sampleRate = newSampleRate;
+        numChannelsPrepared = juce::jmax(1, maxChannels);
+
+        juce::dsp::ProcessSpec spec{ sampleRate, (juce::uint32)chunkSize, (juce::uint32)numChannelsPrepared };
+
+        for (auto& filter : crossovers)
+            filter.prepare(spec);
+
+        for (auto& filter : allpasses)
+        {
+            filter.setType(juce::dsp::LinkwitzRileyFilterType::allpass);
+            filter.prepare(spec);
+        }
+
+        envelopes.assign((size_t)numChannelsPrepared, BandEnvelopes{});
+
+        for (auto* smoother : { &inputGain, &makeupGain })
+            smoother->reset(sampleRate, Kernel::gainRampSeconds);
+
+        inputGain.setCurrentAndTargetValue(juce::Decibels::decibelsToGain((SampleType)params.inputGainDb));
+        makeupGain.setCurrentAndTargetValue(juce::Decibels::decibelsToGain((SampleType)params.makeupGainDb));
+
+        updateCrossovers();
+
+        for (int band = 0; band < maxBands; ++band)
+            updateBand(band);
+    }
+
+    void reset()
+    {
+        for (auto& filter : crossovers)
+            filter.reset();
+
+        for (auto& filter : allpasses)
+            filter.reset();
+
+        std::fill(envelopes.begin(), envelopes.end(), BandEnvelopes{});
+        silenceGate.reset();
+    }
+
+    void setParameters(const Parameters& newParameters) noexcept
+    {
+        if (newParameters.inputGainDb != params.inputGainDb)
+            inputGain.setTargetValue(juce::Decibels::decibelsToGain((SampleType)newParameters.inputGainDb));
+
+        if (newParameters.makeupGainDb != params.makeupGainDb)
+            makeupGain.setTargetValue(juce::Decibels::decibelsToGain((SampleType)newParameters.makeupGainDb));
+
+        auto crossoversChanged = newParameters.crossoverHz != params.crossoverHz;
+        auto kneeChanged = newParameters.kneeDb != params.kneeDb;
+        auto autoChanged = newParameters.autoAttack != params.autoAttack || newParameters.autoRelease != params.autoRelease;
+        auto wasAutomatic = isAutomatic();
+        std::array<bool, maxBands> bandChanged;
+
+        for (int band = 0; band < maxBands; ++band)
+        {
+            auto& a = newParameters.bands[(size_t)band];
+            auto& b = params.bands[(size_t)band];
+            bandChanged[(size_t)band] = a.thresholdDb != b.thresholdDb || a.ratio != b.ratio || a.attackMs != b.attackMs
+                                        || a.releaseMs != b.releaseMs || a.makeupGainDb != b.makeupGainDb;
+        }
+
+        params = newParameters;
+        params.numBands = juce::jlimit(2, maxBands, params.numBands);
+
+        if (crossoversChanged)
+            updateCrossovers();
+
+        for (int band = 0; band < maxBands; ++band)
+            if (bandChanged[(size_t)band] || kneeChanged || autoChanged)
+                updateBand(band);
+
+        if (isAutomatic() && ! wasAutomatic)
+            for (auto& e : envelopes)
+                for (int band = 0; band < maxBands; ++band)
+                    e.autoLanes[band] = Auto::fromEnvelope(e.lanes[band]);
+    }
+
+    // Receives the deepest band gain of each frame; see CompressorKernel.
+    void setGainMeter(GainReductionFifo* meter) noexcept { gainMeter = meter; }
+
+    // Silence fast path; see CompressorKernel::processSilence(). The band
+    // envelopes follow the crossover outputs, so once they have all released
+    // the filters have rung out as well.
+    bool processSilence(SampleType* const* channels, int numChannels, int numSamples) noexcept
+    {
+        numChannels = juce::jmin(numChannels, numChannelsPrepared);
+
+        auto inGain = juce::jmax(inputGain.getCurrentValue(), inputGain.getTargetValue());
+        auto outGain = juce::jmax(makeupGain.getCurrentValue(), makeupGain.getTargetValue());
+        auto bandGain = *std::max_element(std::begin(bandMakeupGains), std::end(bandMakeupGains));
+        auto peak = SilenceGate::getPeak(channels, numChannels, numSamples) * inGain * outGain * bandGain;
+
+        if (! silenceGate.update((double)peak, numSamples, 0))
+            return false;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            for (int band = 0; band < maxBands; ++band)
+            {
+                auto env = envelopes[(size_t)ch].lanes[band];
+
+                if (isAutomatic())
+                    env = juce::jmax(env, envelopes[(size_t)ch].autoLanes[band].slow);
+
+                if (env >= (SampleType)SilenceGate::floor)
+                    return false;
+            }
+        }
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            juce::FloatVectorOperations::clear(channels[ch], numSamples);
+
+        inputGain.skip(numSamples);
+        makeupGain.skip(numSamples);
+
+        if (isAutomatic())
+            for (int ch = 0; ch < numChannels; ++ch)
+                for (int band = 0; band < maxBands; ++band)
+                    Auto::skip(envelopes[(size_t)ch].autoLanes[band], autoCoefficients[band].crest, numSamples);
+
+        if (gainMeter != nullptr && numChannels > 0)
+            gainMeter->pushConstant(1.0f, numSamples);
+
+        return true;
+    }
+
+    // Band detectors and gain stages are branch-free loops over the four
+    // band lanes, like CompressorBank's loops over its compressors, so the
+    // compiler vectorises them on every target whatever its register width.
+    // The auto ballistics run through the same lanes but are a per-band call,
+    // as they carry more state.
+    typename Kernel::Levels process(SampleType* const* channels, int numChannels, int numSamples) noexcept
+    {
+        typename Kernel::Levels levels;
+        numChannels = juce::jmin(numChannels, numChannelsPrepared);
+        auto automatic = isAutomatic();
+
+        for (int start = 0; start < numSamples; start += chunkSize)
+        {
+            auto n = juce::jmin(chunkSize, numSamples - start);
+
+            Kernel::fillGains(inputGain, inGains, n, n);
+            Kernel::fillGains(makeupGain, outGains, n, n);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto* data = channels[ch] + start;
+                auto* env = envelopes[(size_t)ch].lanes;
+
+                for (int i = 0; i < n; ++i)
+                {
+                    auto x = data[i] * inGains[i];
+                    split(ch, x, bands);
+
+                    if (automatic)
+                    {
+                        for (int band = 0; band < maxBands; ++band)
+                            gains[band] = std::abs(bands[band]);
+
+                        followAutomatic(ch, gains);
+                    }
+                    else
+                    {
+                        // 0/1 blends rather than selects, as in CompressorBank.
+                        for (int band = 0; band < maxBands; ++band)
+                        {
+                            auto level = std::abs(bands[band]);
+                            auto rising = (SampleType)(level > env[band]);
+                            auto cte = rising * attackCoefficients[band] + ((SampleType)1 - rising) * releaseCoefficients[band];
+                            env[band] = level + cte * (env[band] - level);
+                            gains[band] = env[band];
+                        }
+                    }
+
+                    computeGains(gains);
+
+                    auto frameGain = lowestGain(gains);
+                    frameGains[i] = ch == 0 ? frameGain : juce::jmin(frameGains[i], frameGain);
+
+                    auto y = SampleType();
+
+                    for (int band = 0; band < maxBands; ++band)
+                        y += bands[band] * gains[band] * bandMakeupGains[band];
+
+                    auto out = y * outGains[i];
+                    data[i] = out;
+
+                    levels.input += x * x;
+                    levels.compressed += y * y;
+                    levels.output += out * out;
+                }
+            }
+
+            if (gainMeter != nullptr && numChannels > 0)
+                gainMeter->push(frameGains, n);
+        }
+
+        return levels;
+    }
+
+    // Per-band reference for process(), one band and one sample at a time,
+    // with the gains ramped per sample rather than per chunk.
+    typename Kernel::Levels processScalar(SampleType* const* channels, int numChannels, int numSamples) noexcept
+    {
+        typename Kernel::Levels levels;
+        numChannels = juce::jmin(numChannels, numChannelsPrepared);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto inGain = inputGain.getNextValue();
+            auto outGain = makeupGain.getNextValue();
+            auto frameGain = (SampleType)1;
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto* env = envelopes[(size_t)ch].lanes;
+                auto x = channels[ch][i] * inGain;
+                split(ch, x, bands);
+
+                for (int band = 0; band < maxBands; ++band)
+                {
+                    auto level = std::abs(bands[band]);
+
+                    if (isAutomatic())
+                    {
+                        gains[band] = Auto::process(level, env[band], envelopes[(size_t)ch].autoLanes[band], autoCoefficients[band]);
+                    }
+                    else
+                    {
+                        auto cte = level > env[band] ? attackCoefficients[band] : releaseCoefficients[band];
+                        env[band] = level + cte * (env[band] - level);
+                        gains[band] = env[band];
+                    }
+                }
+
+                computeGains(gains);
+                frameGain = juce::jmin(frameGain, lowestGain(gains));
+
+                auto y = SampleType();
+
+                for (int band = 0; band < maxBands; ++band)
+                    y += bands[band] * gains[band] * bandMakeupGains[band];
+
+                auto out = y * outGain;
+                channels[ch][i] = out;
+
+                levels.input += x * x;
+                levels.compressed += y * y;
+                levels.output += out * out;
+            }
+
+            if (gainMeter != nullptr && numChannels > 0)
+                gainMeter->push(&frameGain, 1);
+        }
+
+        return levels;
+    }
+
+private:
+    // Cascade of crossovers: band 0 is below crossover 0, band 1 between
+    // crossovers 0 and 1, and so on. Each band is passed through the
+    // allpasses of the crossovers above it so that all bands see the same
+    // phase response. Unused bands are zero.
+    void split(int channel, SampleType x, SampleType* out) noexcept
+    {
+        SampleType low, high;
+
+        crossovers[0].processSample(channel, x, out[0], high);
+
+        if (params.numBands == 2)
+        {
+            out[1] = high;
+            out[2] = out[3] = SampleType();
+            return;
+        }
+
+        crossovers[1].processSample(channel, high, low, high);
+        out[0] = allpasses[0].processSample(channel, out[0]);
+        out[1] = low;
+
+        if (params.numBands == 3)
+        {
+            out[2] = high;
+            out[3] = SampleType();
+            return;
+        }
+
+        crossovers[2].processSample(channel, high, out[2], out[3]);
+        out[0] = allpasses[1].processSample(channel, out[0]);
+        out[1] = allpasses[2].processSample(channel, out[1]);
+    }
+
+    bool isAutomatic() const noexcept { return params.autoAttack || params.autoRelease; }
+
+    // Levels to envelopes in place, one lane per band.
+    void followAutomatic(int channel, SampleType* values) noexcept
+    {
+        auto& e = envelopes[(size_t)channel];
+
+        for (int band = 0; band < maxBands; ++band)
+            values[band] = Auto::process(values[band], e.lanes[band], e.autoLanes[band], autoCoefficients[band]);
+    }
+
+    // Turns envelopes into gains in place, with the single band kernel's
+    // curve. The curve values are held per lane so the loop vectorises.
+    void computeGains(SampleType* values) const noexcept
+    {
+        for (int band = 0; band < maxBands; ++band)
+            values[band] = GainComputer<SampleType>::getGain(values[band], thresholdLog2s[band], slopes[band],
+                                                             kneeWidths[band], kneeFactors[band]);
+    }
+
+    static SampleType lowestGain(const SampleType* values) noexcept
+    {
+        return juce::jmin(juce::jmin(values[0], values[1]), juce::jmin(values[2], values[3]));
+    }
+
+    void updateCrossovers() noexcept
+    {
+        auto nyquistLimit = (float)sampleRate * 0.45f;
+        auto previous = 10.0f;
+
+        // Crossovers are kept in ascending order however the user sets them,
+        // and below the limit even when that leaves two at the same frequency.
+        for (size_t i = 0; i < crossovers.size(); ++i)
+        {
+            auto frequency = juce::jlimit(juce::jmin(previous * 1.01f, nyquistLimit), nyquistLimit, params.crossoverHz[i]);
+            crossovers[i].setCutoffFrequency((SampleType)frequency);
+            previous = frequency;
+
+            if (i == 1)
+                allpasses[0].setCutoffFrequency((SampleType)frequency);
+
+            if (i == 2)
+            {
+                allpasses[1].setCutoffFrequency((SampleType)frequency);
+                allpasses[2].setCutoffFrequency((SampleType)frequency);
+            }
+        }
+    }
+
+    void updateBand(int band) noexcept
+    {
+        auto& b = params.bands[(size_t)band];
+        auto expFactor = -2.0 * juce::MathConstants<double>::pi * 1000.0 / sampleRate;
+        auto coefficient = [expFactor](float timeMs) { return timeMs < 1.0e-3f ? SampleType() : (SampleType)std::exp(expFactor / timeMs); };
+
+        GainComputer<SampleType> curve;
+        curve.setParameters(b.thresholdDb, b.ratio, params.kneeDb);
+        thresholdLog2s[band] = curve.thresholdLog2;
+        slopes[band] = curve.slope;
+        kneeWidths[band] = curve.kneeWidth;
+        kneeFactors[band] = curve.kneeFactor;
+        attackCoefficients[band] = coefficient(b.attackMs);
+        releaseCoefficients[band] = coefficient(b.releaseMs);
+        autoCoefficients[band] = Auto::makeCoefficients(sampleRate, b.attackMs, b.releaseMs, params.autoAttack, params.autoRelease);
+        bandMakeupGains[band] = juce::Decibels::decibelsToGain((SampleType)b.makeupGainDb);
+    }
+
+    // Each band array is one aligned block of four lanes: a 128-bit register
+    // of floats, or 256 bits of doubles.
+    static constexpr size_t laneAlignment = maxBands * sizeof(SampleType);
+
+    static constexpr int chunkSize = 64;
+
+    using Auto = AutoBallistics<SampleType>;
+
+    Parameters params;
+    double sampleRate = 44100.0;
+    int numChannelsPrepared = 0;
+
+    std::array<juce::dsp::LinkwitzRileyFilter<SampleType>, maxBands - 1> crossovers;
+    std::array<juce::dsp::LinkwitzRileyFilter<SampleType>, maxBands - 1> allpasses;
+
+    struct alignas(laneAlignment) BandEnvelopes
+    {
+        SampleType lanes[maxBands] = {};
+        typename Auto::State autoLanes[maxBands];
+    };
+
+    std::vector<BandEnvelopes> envelopes;
+
+    typename Kernel::GainSmoother inputGain{ 1 }, makeupGain{ 1 };
+
+    alignas(laneAlignment) SampleType bands[maxBands] = {};
+    alignas(laneAlignment) SampleType gains[maxBands] = {};
+    alignas(laneAlignment) SampleType thresholdLog2s[maxBands] = {};
+    alignas(laneAlignment) SampleType slopes[maxBands] = {};
+    alignas(laneAlignment) SampleType kneeWidths[maxBands] = {};
+    alignas(laneAlignment) SampleType kneeFactors[maxBands] = {};
+    alignas(laneAlignment) SampleType attackCoefficients[maxBands] = {};
+    alignas(laneAlignment) SampleType releaseCoefficients[maxBands] = {};
+    alignas(laneAlignment) SampleType bandMakeupGains[maxBands] = {};
+    typename Auto::Coefficients autoCoefficients[maxBands];
+    alignas(laneAlignment) SampleType inGains[chunkSize];
+    alignas(laneAlignment) SampleType outGains[chunkSize];
+    SampleType frameGains[chunkSize];
+
+    GainReductionFifo* gainMeter = nullptr;
+    SilenceGate silenceGate;
+};
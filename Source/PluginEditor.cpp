@@ -1,25 +1,42 @@
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "BinaryData.h"
 #include "GRMeter.h"
 
 OneCompAudioProcessorEditor::OneCompAudioProcessorEditor(OneCompAudioProcessor& p)
-    : AudioProcessorEditor(&p), audioProcessor(p), gainReductionMeter(p),
-    thresholdKnob(juce::ImageCache::getFromMemory(BinaryData::oneCompThresholdButton_png, 
+    : AudioProcessorEditor(&p), audioProcessor(p),
+    thresholdKnob(ImageKnob::loadFilmstrip(BinaryData::oneCompThresholdButton_png,
         BinaryData::oneCompThresholdButton_pngSize)),
-    gainKnob(juce::ImageCache::getFromMemory(BinaryData::oneCompGainButton_png,
+    gainKnob(ImageKnob::loadFilmstrip(BinaryData::oneCompGainButton_png,
         BinaryData::oneCompGainButton_pngSize)),
-    attackKnob(juce::ImageCache::getFromMemory(BinaryData::oneCompSmallButton_png,
+    attackKnob(ImageKnob::loadFilmstrip(BinaryData::oneCompSmallButton_png,
         BinaryData::oneCompSmallButton_pngSize)),
-    ratioKnob(juce::ImageCache::getFromMemory(BinaryData::oneCompSmallButton_png,
+    ratioKnob(ImageKnob::loadFilmstrip(BinaryData::oneCompSmallButton_png,
         BinaryData::oneCompSmallButton_pngSize)),
-    releaseKnob(juce::ImageCache::getFromMemory(BinaryData::oneCompSmallButton_png,
+    releaseKnob(ImageKnob::loadFilmstrip(BinaryData::oneCompSmallButton_png,
         BinaryData::oneCompSmallButton_pngSize)),
-    inputKnob(juce::ImageCache::getFromMemory(BinaryData::oneCompInputButton_png,
+    inputKnob(ImageKnob::loadFilmstrip(BinaryData::oneCompInputButton_png,
         BinaryData::oneCompInputButton_pngSize))
 
 {
     background = juce::ImageCache::getFromMemory(BinaryData::oneCompBG_png, BinaryData::oneCompBG_pngSize);
+    autoMakeupValue = audioProcessor.parameters.getRawParameterValue("autoMakeup");
+
+   #if ONECOMP_FRAME_STATS
+    auto* stats = &frameStats;
+   #else
+    FrameTimeStats* stats = nullptr;
+   #endif
+
+    setOpaque(true);
+    backgroundComponent = std::make_unique<BackgroundComponent>(background, stats);
+    addAndMakeVisible(backgroundComponent.get());
+
+    for (auto* knob : { &thresholdKnob, &gainKnob, &attackKnob, &ratioKnob, &releaseKnob, &inputKnob })
+        knob->setFrameStats(stats);
+
+    gainReductionMeter.setFrameStats(stats);
 
     addAndMakeVisible(&thresholdKnob);
     addAndMakeVisible(&gainKnob);
@@ -91,25 +108,36 @@ OneCompAudioProcessorEditor::OneCompAudioProcessorEditor(OneCompAudioProcessor&
     outputLabel.setBounds(550, 825, 250, 80);
     addAndMakeVisible(outputLabel);
 
+    loudnessLabel.setFont(juce::Font(16.0f, juce::Font::bold));
+    loudnessLabel.setColour(juce::Label::textColourId, juce::Colours::black);
+    loudnessLabel.setJustificationType(juce::Justification::centred);
+    addAndMakeVisible(loudnessLabel);
+
+    meterPoints.resize(GainReductionFifo::capacity);
+    gainReductionMeter.setBounds(75, 800, 725, 20);
+    addAndMakeVisible(gainReductionMeter);
+
     menuBar = std::make_unique<juce::MenuBarComponent>(this);
     addAndMakeVisible(menuBar.get());
 
     setSize(background.getWidth(), background.getHeight());
 
-    startTimer(100);
+    startTimerHz(30);
 }
 
 OneCompAudioProcessorEditor::~OneCompAudioProcessorEditor()
 {   
     stopTimer();
+    visualiserWindow.deleteAndZero();
+
+   #if ONECOMP_PROCESS_STATS
+    diagnosticsWindow.deleteAndZero();
+   #endif
 }
 
-void OneCompAudioProcessorEditor::paint(juce::Graphics& g)
+void OneCompAudioProcessorEditor::paint(juce::Graphics&)
 {
-    g.fillAll(getLookAndFeel().findColour(juce::ResizableWindow::backgroundColourId));
-    g.setColour(juce::Colours::white);
-    g.setFont(15.0f);
-    g.drawImageAt(background, 0, 0);
+    // Everything is drawn by the cached backgroundComponent and the children.
 }
 
 void OneCompAudioProcessorEditor::resized()
@@ -172,22 +200,56 @@ void OneCompAudioProcessorEditor::resized()
     int inputKnobY = knobY - 145; 
     inputKnob.setBounds(inputKnobX, inputKnobY, knobBounds.getWidth(), knobBounds.getHeight());
 
+    backgroundComponent->setBounds(getLocalBounds());
+
     auto bounds = getLocalBounds();
     auto menuBarHeight = juce::LookAndFeel::getDefaultLookAndFeel().getDefaultMenuBarHeight();
 
     menuBar->setBounds(bounds.removeFromTop(menuBarHeight));
+    loudnessLabel.setBounds(bounds.removeFromBottom(24).reduced(75, 0));
 }
 
 void OneCompAudioProcessorEditor::timerCallback()
 {
+   #if ONECOMP_FRAME_STATS
+    FrameTimeStats::Scope scope(&frameStats, FrameTimeStats::timer);
+   #endif
+
+    // The editor's timer is the FIFO's only reader.
+    auto numPoints = audioProcessor.getGainReductionFifo().pop(meterPoints.data(), (int)meterPoints.size());
+    gainReductionMeter.addPoints(meterPoints.data(), numPoints);
+
+    // The meter runs at the full timer rate; the large readouts only need 10 Hz.
+    if (++labelTick < 3)
+        return;
+
+    labelTick = 0;
+
     auto inputDb = audioProcessor.getInputLevel();
     inputLabel.setText(juce::String(inputDb, 1), juce::dontSendNotification);
 
-    auto grDb = audioProcessor.getGainReduction();
+    auto grDb = gainReductionMeter.getPeakReduction();
     gainReductionLabel.setText(juce::String(grDb, 1), juce::dontSendNotification);
 
     auto outputDb = audioProcessor.getOutputLevel();
     outputLabel.setText(juce::String(outputDb, 1), juce::dontSendNotification);
+
+    auto format = [](float value) { return value > LoudnessMeterBase::minLoudness ? juce::String(value, 1) : juce::String("--"); };
+    auto loudness = audioProcessor.getLoudness();
+    auto text = "M " + format(loudness.momentary) + "   S " + format(loudness.shortTerm) + "   I " + format(loudness.integrated)
+                + " LUFS   LRA " + juce::String(loudness.range, 1) + " LU   TP " + format(loudness.truePeak) + " dBTP";
+
+    if (autoMakeupValue->load() >= 0.5f)
+        text << "   Auto " << juce::String(audioProcessor.getAutoMakeupGain(), 1) << " dB";
+
+    loudnessLabel.setText(text, juce::dontSendNotification);
+
+   #if ONECOMP_FRAME_STATS
+    auto summary = frameStats.takeSummary();
+
+    if (summary.isNotEmpty())
+        juce::Logger::writeToLog("oneComp editor: " + summary);
+   #endif
 }
 
 void OneCompAudioProcessorEditor::initializeKnob(ImageKnob& knob, const juce::String& parameterId)
@@ -200,7 +262,7 @@ void OneCompAudioProcessorEditor::initializeKnob(ImageKnob& knob, const juce::St
 
 juce::StringArray OneCompAudioProcessorEditor::getMenuBarNames()
 {
-    return { "File", "Edit", "Help" };
+    return { "File", "Edit", "View", "Help" };
 }
 
 juce::PopupMenu OneCompAudioProcessorEditor::getMenuForIndex(int topLevelMenuIndex, const juce::String& menuName)
@@ -217,10 +279,21 @@ juce::PopupMenu OneCompAudioProcessorEditor::getMenuForIndex(int topLevelMenuInd
     {
         menu.addItem(4, "Undo");
         menu.addItem(5, "Redo");
+        menu.addSeparator();
+        menu.addItem(8, "Reset Loudness");
+    }
+    else if (menuName == "View")
+    {
+        menu.addItem(9, "Curve and Waveform...");
     }
     else if (menuName == "Help")
     {
         menu.addItem(6, "About");
+
+       #if ONECOMP_PROCESS_STATS
+        if (juce::ModifierKeys::getCurrentModifiersRealtime().isShiftDown())
+            menu.addItem(7, "Diagnostics...");
+       #endif
     }
     return menu;
 }
@@ -232,5 +305,52 @@ void OneCompAudioProcessorEditor::menuItemSelected(int menuItemID, int topLevelM
     case 1: /* Open */ break;
     case 2: /* Save */ break;
     case 3: /* Exit */ break;
+    case 7: showDiagnostics(); break;
+    case 8: audioProcessor.resetLoudness(); break;
+    case 9: showVisualiser(); break;
+    }
+}
+
+void OneCompAudioProcessorEditor::showVisualiser()
+{
+    if (visualiserWindow != nullptr)
+    {
+        visualiserWindow->toFront(true);
+        return;
+    }
+
+   #if ONECOMP_FRAME_STATS
+    auto* stats = &frameStats;
+   #else
+    FrameTimeStats* stats = nullptr;
+   #endif
+
+    juce::DialogWindow::LaunchOptions options;
+    options.content.setOwned(new VisualiserPage(audioProcessor, stats));
+    options.dialogTitle = "oneComp curve and waveform";
+    options.componentToCentreAround = this;
+    options.escapeKeyTriggersCloseButton = true;
+    options.useNativeTitleBar = true;
+    options.resizable = false;
+    visualiserWindow = options.launchAsync();
+}
+
+void OneCompAudioProcessorEditor::showDiagnostics()
+{
+   #if ONECOMP_PROCESS_STATS
+    if (diagnosticsWindow != nullptr)
+    {
+        diagnosticsWindow->toFront(true);
+        return;
     }
+
+    juce::DialogWindow::LaunchOptions options;
+    options.content.setOwned(new DiagnosticsPage(audioProcessor));
+    options.dialogTitle = "oneComp diagnostics";
+    options.componentToCentreAround = this;
+    options.escapeKeyTriggersCloseButton = true;
+    options.useNativeTitleBar = true;
+    options.resizable = false;
+    diagnosticsWindow = options.launchAsync();
+   #endif
 }
\ No newline at end of file
@@ -4,42 +4,111 @@
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
 #include "GRMeter.h"
+#include "FrameTimeStats.h"
+#include "DiagnosticsPage.h"
+#include "VisualiserPage.h"
 
+// Logs the editor's message-thread paint and timer time every two seconds.
+#ifndef ONECOMP_FRAME_STATS
+ #define ONECOMP_FRAME_STATS JUCE_DEBUG
+#endif
+
+// Rotary knob drawn from a filmstrip of pre-rotated frames, so painting is a
+// single unscaled blit instead of a transformed, resampled image draw.
 class ImageKnob : public juce::Slider {
 public:
-    ImageKnob(const juce::Image& knobImage) : image(knobImage) {
+    static constexpr int numFrames = 128;
+    static constexpr float startAngle = juce::MathConstants<float>::pi * 1.25f;
+    static constexpr float endAngle = juce::MathConstants<float>::pi * 2.75f;
+
+    ImageKnob(const juce::Image& knobFilmstrip)
+        : filmstrip(knobFilmstrip), frameHeight(knobFilmstrip.getHeight() / numFrames) {
         setSliderStyle(SliderStyle::RotaryHorizontalVerticalDrag);
         setTextBoxStyle(NoTextBox, false, 0, 0);
-        setRotaryParameters(juce::MathConstants<float>::pi * 1.25f,
-            juce::MathConstants<float>::pi * 2.75f, true);
+        setRotaryParameters(startAngle, endAngle, true);
+    }
+
+    // Renders numFrames rotations of the knob image into one vertical strip.
+    // Strips are kept in the ImageCache, so knobs sharing an image, and every
+    // open editor, share a single strip.
+    static juce::Image loadFilmstrip(const void* imageData, int dataSize) {
+        auto hashCode = (juce::int64)(juce::pointer_sized_int)imageData * 31 + numFrames;
+        auto strip = juce::ImageCache::getFromHashCode(hashCode);
+
+        if (strip.isValid())
+            return strip;
+
+        auto image = juce::ImageCache::getFromMemory(imageData, dataSize);
+        auto w = image.getWidth();
+        auto h = image.getHeight();
+        strip = juce::Image(juce::Image::ARGB, w, h * numFrames, true);
+
+        juce::Graphics g(strip);
+        g.setImageResamplingQuality(juce::Graphics::highResamplingQuality);
+
+        for (int frame = 0; frame < numFrames; ++frame) {
+            juce::Graphics::ScopedSaveState state(g);
+            g.reduceClipRegion(0, frame * h, w, h);
+
+            auto angle = juce::jmap((float)frame, 0.0f, (float)(numFrames - 1), startAngle, endAngle);
+            g.drawImageTransformed(image, juce::AffineTransform::translation(-w / 2.0f, -h / 2.0f)
+                                              .rotated(angle)
+                                              .translated(w / 2.0f, h / 2.0f + (float)(frame * h)));
+        }
+
+        juce::ImageCache::addImageToCache(strip, hashCode);
+        return strip;
     }
 
     juce::Rectangle<int> getImageBounds() const {
-        return juce::Rectangle<int>(image.getWidth(), image.getHeight());
+        return juce::Rectangle<int>(filmstrip.getWidth(), frameHeight);
     }
 
-    void ImageKnob::paint(juce::Graphics& g) {
-        auto bounds = getLocalBounds().toFloat();
-        auto rotationCentre = bounds.getCentre();
-        auto angle = getRotaryAngle();
+    void setFrameStats(FrameTimeStats* stats) { frameStats = stats; }
+
+    void paint(juce::Graphics& g) override {
+        FrameTimeStats::Scope scope(frameStats, FrameTimeStats::paint);
 
-        juce::AffineTransform transform = juce::AffineTransform::translation(-image.getWidth() / 2.0f, -image.getHeight() / 2.0f) 
-            .rotated(angle) 
-            .translated(rotationCentre.getX(), rotationCentre.getY()); 
+        auto centre = getLocalBounds().getCentre();
+        auto w = filmstrip.getWidth();
 
-        g.drawImageTransformed(image, transform, false);
+        g.drawImage(filmstrip, centre.getX() - w / 2, centre.getY() - frameHeight / 2, w, frameHeight,
+                    0, getFrameIndex() * frameHeight, w, frameHeight);
     }
 
 private:
-    juce::Image image;
+    juce::Image filmstrip;
+    int frameHeight;
+    FrameTimeStats* frameStats = nullptr;
 
-    float getRotaryAngle() const {
-        return juce::jmap<float>(getValue(), getMinimum(), getMaximum(),
-            juce::MathConstants<float>::pi * 1.25f,
-            juce::MathConstants<float>::pi * 2.75f);
+    int getFrameIndex() const {
+        auto frame = juce::jmap<double>(getValue(), getMinimum(), getMaximum(), 0.0, numFrames - 1.0);
+        return juce::jlimit(0, numFrames - 1, juce::roundToInt(frame));
     }
 };
 
+// Static background, rendered once into a cached image so that repaints of
+// the knobs and meters above it only composite that image.
+class BackgroundComponent : public juce::Component {
+public:
+    BackgroundComponent(const juce::Image& backgroundImage, FrameTimeStats* stats)
+        : image(backgroundImage), frameStats(stats) {
+        setOpaque(true);
+        setBufferedToImage(true);
+        setInterceptsMouseClicks(false, false);
+    }
+
+    void paint(juce::Graphics& g) override {
+        FrameTimeStats::Scope scope(frameStats, FrameTimeStats::paint);
+        g.fillAll(getLookAndFeel().findColour(juce::ResizableWindow::backgroundColourId));
+        g.drawImageAt(image, 0, 0);
+    }
+
+private:
+    juce::Image image;
+    FrameTimeStats* frameStats;
+};
+
 class OneCompAudioProcessorEditor : public juce::AudioProcessorEditor, public juce::Timer, public juce::MenuBarModel
 {
 
@@ -60,10 +129,18 @@ public:
     void menuItemSelected(int menuItemID, int topLevelMenuIndex) override;
 
 private:
+    void showDiagnostics();
+    void showVisualiser();
+
     OneCompAudioProcessor& audioProcessor;
+    std::atomic<float>* autoMakeupValue = nullptr; // cached so the timer never looks it up by name
+    FrameTimeStats frameStats;
     GainReductionMeter gainReductionMeter; 
+    std::vector<GainReductionFifo::Point> meterPoints;
 
     juce::Image background;
+    std::unique_ptr<BackgroundComponent> backgroundComponent;
+    int labelTick = 0;
     ImageKnob thresholdKnob;
     ImageKnob gainKnob;
     ImageKnob attackKnob;
@@ -87,6 +164,12 @@ private:
 
     std::unique_ptr<juce::MenuBarComponent> menuBar;
 
+    juce::Component::SafePointer<juce::DialogWindow> visualiserWindow;
+
+   #if ONECOMP_PROCESS_STATS
+    juce::Component::SafePointer<juce::DialogWindow> diagnosticsWindow;
+   #endif
+
     juce::Label thresholdLabel;
     juce::Label ratioLabel;
     juce::Label attackLabel;
@@ -96,6 +179,7 @@ private:
     juce::Label inputLabel;
     juce::Label gainReductionLabel;
     juce::Label outputLabel;
+    juce::Label loudnessLabel;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OneCompAudioProcessorEditor)
 };
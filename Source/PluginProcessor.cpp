@@ -1,7 +1,10 @@
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
-#include "PluginEditor.h"
-#include "GRMeter.h"
+
+#if ! ONECOMP_HEADLESS
+ #include "PluginEditor.h"
+ #include "GRMeter.h"
+#endif
 
 using namespace juce;
 
@@ -11,6 +14,7 @@ OneCompAudioProcessor::OneCompAudioProcessor()
 #if ! JucePlugin_IsMidiEffect
 #if ! JucePlugin_IsSynth
         .withInput("Input", juce::AudioChannelSet::stereo(), true)
+        .withInput("Sidechain", juce::AudioChannelSet::stereo(), false)
 #endif
         .withOutput("Output", juce::AudioChannelSet::stereo(), true)
 #endif
@@ -60,9 +64,201 @@ OneCompAudioProcessor::OneCompAudioProcessor()
         0.0f 
     ));
 
+    parameters.createAndAddParameter(std::make_unique<juce::AudioParameterFloat>(
+        "lookahead",
+        "Lookahead",
+        NormalisableRange<float>(0.0f, CompressorKernelBase::maxLookaheadMs, 0.1f),
+        0.0f
+    ));
+
+    parameters.createAndAddParameter(std::make_unique<juce::AudioParameterFloat>(
+        "knee",
+        "Knee",
+        NormalisableRange<float>(0.0f, GainComputer<float>::maxKneeDb, 0.1f),
+        0.0f
+    ));
+
+    parameters.createAndAddParameter(std::make_unique<juce::AudioParameterChoice>(
+        "detector",
+        "Detector",
+        juce::StringArray{ "Peak", "RMS", "True Peak" },
+        0
+    ));
+
+    parameters.createAndAddParameter(std::make_unique<juce::AudioParameterFloat>(
+        "rmsWindow",
+        "RMS Window",
+        NormalisableRange<float>(LevelDetectorBase::minRmsWindowMs, LevelDetectorBase::maxRmsWindowMs, 0.1f, 0.5f),
+        10.0f
+    ));
+
+    parameters.createAndAddParameter(std::make_unique<juce::AudioParameterChoice>(
+        "link",
+        "Stereo Link",
+        juce::StringArray{ "Unlinked", "Linked (Max)", "Linked (Average)", "Mid/Side" },
+        0
+    ));
+
+    parameters.createAndAddParameter(std::make_unique<juce::AudioParameterChoice>(
+        "oversampling",
+        "Oversampling",
+        juce::StringArray{ "Off", "2x", "4x", "8x" },
+        0
+    ));
+
+    parameters.createAndAddParameter(std::make_unique<juce::AudioParameterChoice>(
+        "oversamplingFilter",
+        "Oversampling Filter",
+        juce::StringArray{ "IIR (low latency)", "FIR (linear phase)" },
+        0
+    ));
+
+    parameters.createAndAddParameter(std::make_unique<juce::AudioParameterBool>(
+        "sidechain",
+        "External Sidechain",
+        false
+    ));
+
+    parameters.createAndAddParameter(std::make_unique<juce::AudioParameterFloat>(
+        "keyHighPass",
+        "Key High Pass",
+        NormalisableRange<float>(KeyFilterBase::minFrequency, 2000.0f, 1.0f, 0.3f),
+        KeyFilterBase::minFrequency
+    ));
+
+    parameters.createAndAddParameter(std::make_unique<juce::AudioParameterFloat>(
+        "keyLowPass",
+        "Key Low Pass",
+        NormalisableRange<float>(1000.0f, KeyFilterBase::maxFrequency, 1.0f, 0.3f),
+        KeyFilterBase::maxFrequency
+    ));
+
+    parameters.createAndAddParameter(std::make_unique<juce::AudioParameterFloat>(
+        "keyTilt",
+        "Key Tilt",
+        NormalisableRange<float>(-KeyFilterBase::maxTiltDb, KeyFilterBase::maxTiltDb, 0.1f),
+        0.0f
+    ));
+
+    parameters.createAndAddParameter(std::make_unique<juce::AudioParameterBool>(
+        "autoAttack",
+        "Auto Attack",
+        false
+    ));
+
+    parameters.createAndAddParameter(std::make_unique<juce::AudioParameterBool>(
+        "autoRelease",
+        "Auto Release",
+        false
+    ));
+
+    parameters.createAndAddParameter(std::make_unique<juce::AudioParameterBool>(
+        "bypass",
+        "Bypass",
+        false
+    ));
+
+    parameters.createAndAddParameter(std::make_unique<juce::AudioParameterChoice>(
+        "bands",
+        "Bands",
+        juce::StringArray{ "Single band", "2 bands", "3 bands", "4 bands" },
+        0
+    ));
+
+    const float crossoverDefaults[] = { 120.0f, 1000.0f, 6000.0f };
+
+    for (int i = 0; i < MultibandCompressorBase::maxBands - 1; ++i)
+    {
+        parameters.createAndAddParameter(std::make_unique<juce::AudioParameterFloat>(
+            "crossover" + juce::String(i + 1),
+            "Crossover " + juce::String(i + 1),
+            NormalisableRange<float>(20.0f, 20000.0f, 1.0f, 0.25f),
+            crossoverDefaults[i]
+        ));
+    }
+
+    for (int band = 1; band <= MultibandCompressorBase::maxBands; ++band)
+    {
+        auto id = "band" + juce::String(band);
+        auto name = "Band " + juce::String(band) + " ";
+
+        parameters.createAndAddParameter(std::make_unique<juce::AudioParameterFloat>(
+            id + "Threshold", name + "Threshold", NormalisableRange<float>(-60.0f, 0.0f, 1.0f, 1.0f), -20.0f));
+        parameters.createAndAddParameter(std::make_unique<juce::AudioParameterFloat>(
+            id + "Ratio", name + "Ratio", NormalisableRange<float>(1.0f, 25.0f, 0.1f, 0.7f), 3.0f));
+        parameters.createAndAddParameter(std::make_unique<juce::AudioParameterFloat>(
+            id + "Attack", name + "Attack", NormalisableRange<float>(0.1f, 150.0f, 0.05f, 0.5f), 10.0f));
+        parameters.createAndAddParameter(std::make_unique<juce::AudioParameterFloat>(
+            id + "Release", name + "Release", NormalisableRange<float>(1.5f, 2000.0f, 0.1f, 0.5f), 150.0f));
+        parameters.createAndAddParameter(std::make_unique<juce::AudioParameterFloat>(
+            id + "Gain", name + "Gain", NormalisableRange<float>(-30.0f, 30.0f), 0.0f));
+    }
+
+    parameters.createAndAddParameter(std::make_unique<juce::AudioParameterBool>(
+        "autoMakeup",
+        "Auto Makeup",
+        false
+    ));
+
+    parameters.createAndAddParameter(std::make_unique<juce::AudioParameterFloat>(
+        "loudnessTarget",
+        "Loudness Target",
+        NormalisableRange<float>(-36.0f, -6.0f, 0.1f),
+        -14.0f
+    ));
+
     parameters.state = juce::ValueTree("savedParams");
+    compactState = std::make_unique<CompactState>(getParameters());
+    startTimerHz(20);
 
-    
+    thresholdValue = parameters.getRawParameterValue("threshold");
+    ratioValue = parameters.getRawParameterValue("ratio");
+    attackValue = parameters.getRawParameterValue("attack");
+    releaseValue = parameters.getRawParameterValue("release");
+    gainValue = parameters.getRawParameterValue("gain");
+    inputValue = parameters.getRawParameterValue("input");
+    lookaheadValue = parameters.getRawParameterValue("lookahead");
+    kneeValue = parameters.getRawParameterValue("knee");
+    detectorValue = parameters.getRawParameterValue("detector");
+    rmsWindowValue = parameters.getRawParameterValue("rmsWindow");
+    linkValue = parameters.getRawParameterValue("link");
+    oversamplingValue = parameters.getRawParameterValue("oversampling");
+    oversamplingFilterValue = parameters.getRawParameterValue("oversamplingFilter");
+    bandsValue = parameters.getRawParameterValue("bands");
+    sidechainValue = parameters.getRawParameterValue("sidechain");
+    keyHighPassValue = parameters.getRawParameterValue("keyHighPass");
+    keyLowPassValue = parameters.getRawParameterValue("keyLowPass");
+    keyTiltValue = parameters.getRawParameterValue("keyTilt");
+    autoAttackValue = parameters.getRawParameterValue("autoAttack");
+    autoReleaseValue = parameters.getRawParameterValue("autoRelease");
+    bypassValue = parameters.getRawParameterValue("bypass");
+    autoMakeupValue = parameters.getRawParameterValue("autoMakeup");
+    loudnessTargetValue = parameters.getRawParameterValue("loudnessTarget");
+
+    floatChain.kernel.setGainMeter(&gainReductionFifo);
+    floatChain.multibandCompressor.setGainMeter(&gainReductionFifo);
+    doubleChain.kernel.setGainMeter(&gainReductionFifo);
+    doubleChain.multibandCompressor.setGainMeter(&gainReductionFifo);
+   #if ! ONECOMP_HEADLESS
+    gainReductionFifo.setWaveformHistory(&waveformHistory);
+   #endif
+
+    for (size_t i = 0; i < crossoverValues.size(); ++i)
+        crossoverValues[i] = parameters.getRawParameterValue("crossover" + juce::String((int)i + 1));
+
+    for (size_t band = 0; band < bandValues.size(); ++band)
+    {
+        auto id = "band" + juce::String((int)band + 1);
+        bandValues[band] = { parameters.getRawParameterValue(id + "Threshold"),
+                             parameters.getRawParameterValue(id + "Ratio"),
+                             parameters.getRawParameterValue(id + "Attack"),
+                             parameters.getRawParameterValue(id + "Release"),
+                             parameters.getRawParameterValue(id + "Gain") };
+    }
+
+    // Every parameter comes from the value tree state, so all are ranged.
+    for (auto* parameter : getParameters())
+        rawParameterValues.push_back(parameters.getRawParameterValue(static_cast<juce::RangedAudioParameter*>(parameter)->paramID));
 }
 
 OneCompAudioProcessor::~OneCompAudioProcessor()
@@ -73,7 +269,11 @@ OneCompAudioProcessor::~OneCompAudioProcessor()
 
 const juce::String OneCompAudioProcessor::getName() const
 {
+#if ONECOMP_HEADLESS
+    return "oneComp";
+#else
     return JucePlugin_Name;
+#endif
 }
 
 bool OneCompAudioProcessor::acceptsMidi() const
@@ -105,40 +305,190 @@ bool OneCompAudioProcessor::isMidiEffect() const
 
 double OneCompAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    auto sampleRate = getSampleRate();
+    return sampleRate > 0.0 ? getLatencySamples() / sampleRate : 0.0;
 }
 
 int OneCompAudioProcessor::getNumPrograms()
 {
-    return 1;   
+    return juce::jmax(1, presetBank->getNumPresets());
 }
 
 int OneCompAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return currentProgram;
 }
 
 void OneCompAudioProcessor::setCurrentProgram(int index)
 {
+    if (presetBank->load(index, [this](const void* data, size_t size) { return compactState->load(data, size); }))
+        currentProgram = index;
 }
 
 const juce::String OneCompAudioProcessor::getProgramName(int index)
 {
-    return {};
+    return presetBank->getName(index);
 }
 
 void OneCompAudioProcessor::changeProgramName(int index, const juce::String& newName)
 {
+    if (presetBank->rename(index, newName))
+        updateHostDisplay();
+}
+
+bool OneCompAudioProcessor::savePreset(const juce::String& name)
+{
+    juce::MemoryBlock state;
+    compactState->save(state);
+
+    auto index = presetBank->save(name, state);
+
+    if (index < 0)
+        return false;
+
+    currentProgram = index;
+    updateHostDisplay();
+    return true;
+}
+
+bool OneCompAudioProcessor::addParameterChange(int sampleOffset, int parameterIndex, float value) noexcept
+{
+    if (numParameterChanges == maxParameterChanges || ! juce::isPositiveAndBelow(parameterIndex, (int)rawParameterValues.size()))
+        return false;
+
+    // Changes usually arrive in order, so this rarely moves anything.
+    auto position = numParameterChanges++;
+
+    for (; position > 0 && parameterChanges[(size_t)position - 1].sampleOffset > sampleOffset; --position)
+        parameterChanges[(size_t)position] = parameterChanges[(size_t)position - 1];
+
+    parameterChanges[(size_t)position] = { juce::jmax(0, sampleOffset), parameterIndex, juce::jlimit(0.0f, 1.0f, value) };
+    return true;
+}
+
+// The parameter and the raw value the DSP reads are both set directly:
+// notifying listeners would take locks on the audio thread, and the caller
+// is the host, so there is no one else to tell.
+void OneCompAudioProcessor::applyParameterChange(const ParameterChange& change) noexcept
+{
+    auto* parameter = static_cast<juce::RangedAudioParameter*>(getParameters().getUnchecked(change.parameterIndex));
+    parameter->setValue(change.value);
+    rawParameterValues[(size_t)change.parameterIndex]->store(parameter->convertFrom0to1(change.value), std::memory_order_relaxed);
+}
+
+LoudnessMeterBase::Snapshot OneCompAudioProcessor::getLoudness() const noexcept
+{
+    return isUsingDoublePrecision() ? doubleChain.outputMeter.getSnapshot() : floatChain.outputMeter.getSnapshot();
+}
+
+float OneCompAudioProcessor::getAutoMakeupGain() const noexcept
+{
+    return autoMakeupGainDb.load(std::memory_order_relaxed);
 }
 
+void OneCompAudioProcessor::resetLoudness() noexcept
+{
+    floatChain.outputMeter.reset();
+    doubleChain.outputMeter.reset();
+}
+
+#if ONECOMP_PROCESS_STATS
+ProcessStats::Snapshot OneCompAudioProcessor::getProcessStats() const noexcept
+{
+    return processStats.getSnapshot();
+}
+
+void OneCompAudioProcessor::resetProcessStats() noexcept
+{
+    processStats.reset();
+}
+#endif
+
 void OneCompAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-    juce::dsp::ProcessSpec spec;
-    spec.sampleRate = sampleRate;
-    spec.maximumBlockSize = samplesPerBlock;
-    spec.numChannels = getTotalNumOutputChannels();
+    multibandActive = getNumBands() > 1;
+    maxBlockSize = juce::jmax(1, samplesPerBlock);
+
+   #if ONECOMP_PROCESS_STATS
+    processStats.prepare(sampleRate);
+   #endif
+
+    // The host sets the precision before preparing, and prepares again if it
+    // changes it.
+    int latency;
+
+    if (isUsingDoublePrecision())
+    {
+        prepareChain(doubleChain, sampleRate, samplesPerBlock);
+        latency = getCurrentLatency(doubleChain);
+    }
+    else
+    {
+        prepareChain(floatChain, sampleRate, samplesPerBlock);
+        latency = getCurrentLatency(floatChain);
+    }
+
+    reportedLatency.store(latency);
+    setLatencySamples(latency);
+
+    waveformHistory.prepare(sampleRate, GainReductionFifo::defaultSamplesPerPoint);
+}
+
+template <typename SampleType>
+void OneCompAudioProcessor::prepareChain(DspChain<SampleType>& chain, double sampleRate, int samplesPerBlock)
+{
+    using Oversampling = juce::dsp::Oversampling<SampleType>;
+    auto numChannels = juce::jmax(getMainBusNumInputChannels(), getMainBusNumOutputChannels());
+
+    chain.kernel.setParameters(getParameterSnapshot());
+    chain.kernel.prepare(sampleRate, numChannels, 1 << maxOversamplingOrder);
+
+    // Every factor/filter combination is built up front so that switching
+    // between them on the audio thread never allocates.
+    for (int filter = 0; filter < 2; ++filter)
+    {
+        auto type = filter == 0 ? Oversampling::filterHalfBandPolyphaseIIR
+                                : Oversampling::filterHalfBandFIREquiripple;
+
+        for (int order = 1; order <= maxOversamplingOrder; ++order)
+        {
+            auto& oversampler = chain.oversamplers[(size_t)(filter * maxOversamplingOrder + order - 1)];
+            oversampler = std::make_unique<Oversampling>((size_t)numChannels, (size_t)order, type, filter == 1, true);
+            oversampler->initProcessing((size_t)samplesPerBlock);
+        }
+    }
+
+    chain.channelPointers.assign((size_t)numChannels, nullptr);
+    chain.keyPointers.assign((size_t)numChannels, nullptr);
+    chain.keyBuffer.setSize(numChannels, samplesPerBlock);
+
+    chain.keyFilter.prepare({ sampleRate, (juce::uint32)samplesPerBlock, (juce::uint32)numChannels });
+    chain.keyFilter.setParameters(getKeyFilterSnapshot());
+    chain.activeOversampler = nullptr;
+    updateOversampler(chain);
+
+    chain.multibandCompressor.setParameters(getMultibandSnapshot());
+    chain.multibandCompressor.prepare(sampleRate, numChannels);
+
+    // The dry path is delayed by the longest latency any setting can add.
+    auto maxOversamplerLatency = 0;
+
+    for (auto& oversampler : chain.oversamplers)
+        maxOversamplerLatency = juce::jmax(maxOversamplerLatency, (int)std::ceil(oversampler->getLatencyInSamples()));
 
-    compressor.prepare(spec);
+    auto maxLatency = (int)std::ceil(CompressorKernelBase::maxLookaheadMs * 0.001 * sampleRate) + maxOversamplerLatency;
+
+    chain.bypass.setBypassed(bypassValue->load() >= 0.5f);
+    chain.bypass.prepare(sampleRate, numChannels, maxLatency, samplesPerBlock);
+    chain.suspended = false;
+
+    auto weights = LoudnessMeterBase::getChannelWeights(getChannelLayoutOfBus(false, 0), numChannels);
+    chain.makeupMeter.prepare(sampleRate, weights, false);
+    chain.outputMeter.prepare(sampleRate, weights);
+    chain.autoMakeup.reset(sampleRate, 1.0);
+    chain.autoMakeup.setCurrentAndTargetValue(1);
+    chain.autoMakeupActive = false;
+    autoMakeupGainDb.store(0.0f);
 }
 
 void OneCompAudioProcessor::releaseResources()
@@ -153,13 +503,25 @@ bool OneCompAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) c
     juce::ignoreUnused(layouts);
     return true;
 #else
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-        && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Anything from mono up to 7.1.4, one channel per kernel channel.
+    auto mainOutput = layouts.getMainOutputChannelSet();
+
+    if (mainOutput.isDisabled() || mainOutput.size() > maxMainChannels)
         return false;
 
 #if ! JucePlugin_IsSynth
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
         return false;
+
+    if (layouts.inputBuses.size() > 1)
+    {
+        auto sidechain = layouts.getChannelSet(true, 1);
+
+        if (! sidechain.isDisabled()
+            && sidechain != juce::AudioChannelSet::mono()
+            && sidechain != juce::AudioChannelSet::stereo())
+            return false;
+    }
 #endif
 
     return true;
@@ -167,89 +529,359 @@ bool OneCompAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) c
 }
 #endif
 
-void OneCompAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+bool OneCompAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+juce::AudioProcessorParameter* OneCompAudioProcessor::getBypassParameter() const
+{
+    return parameters.getParameter("bypass");
+}
+
+void OneCompAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+{
+    processChain(floatChain, buffer);
+}
+
+void OneCompAudioProcessor::processBlock(juce::AudioBuffer<double>& buffer, juce::MidiBuffer&)
 {
+    processChain(doubleChain, buffer);
+}
+
+template <typename SampleType>
+void OneCompAudioProcessor::processChain(DspChain<SampleType>& chain, juce::AudioBuffer<SampleType>& buffer)
+{
+    RealtimeAudit::ScopedAudioThread audioThread;
+   #if ONECOMP_PROCESS_STATS
+    ProcessStats::Scope timing(processStats, buffer.getNumSamples());
+   #endif
     juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
+    auto totalNumInputChannels = getMainBusNumInputChannels();
+    auto totalNumOutputChannels = getMainBusNumOutputChannels();
+    auto numSamples = buffer.getNumSamples();
 
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
-        buffer.clear(i, 0, buffer.getNumSamples());
+        buffer.clear(i, 0, numSamples);
 
-    float inputGain = *parameters.getRawParameterValue("input");
-    
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
+   #if ! ONECOMP_HEADLESS
+    auto visualising = waveformHistory.beginBlock();
+
+    if (visualising)
+        waveformHistory.pushInput(buffer.getArrayOfReadPointers(), totalNumInputChannels, numSamples);
+   #endif
+
+    // Queued parameter changes split the block, so each takes effect on its
+    // own sample and everything below sees the values of its sub-block only.
+    // So does the prepared block size, for hosts that exceed it, so nothing
+    // below has to grow its buffers on the audio thread. Otherwise the block
+    // is processed whole.
+    typename CompressorKernel<SampleType>::Levels levels;
+    auto numLevelSamples = 0;
+    auto nextChange = 0;
+
+    for (int start = 0; start < numSamples;)
     {
-        auto* channelData = buffer.getWritePointer(channel);
-        for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
+        for (; nextChange < numParameterChanges && parameterChanges[(size_t)nextChange].sampleOffset <= start; ++nextChange)
+            applyParameterChange(parameterChanges[(size_t)nextChange]);
+
+        auto end = nextChange < numParameterChanges ? juce::jmin(numSamples, parameterChanges[(size_t)nextChange].sampleOffset)
+                                                    : numSamples;
+        end = juce::jmin(end, start + maxBlockSize);
+
+        if (start == 0 && end == numSamples)
         {
-            // Apply input gain directly to the sample
-            channelData[sample] *= juce::Decibels::decibelsToGain(inputGain);
+            numLevelSamples = processSubBlock(chain, buffer, levels);
         }
+        else
+        {
+            juce::AudioBuffer<SampleType> subBlock(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), start, end - start);
+            numLevelSamples += processSubBlock(chain, subBlock, levels);
+        }
+
+        start = end;
     }
 
-    auto inputLevel = buffer.getRMSLevel(0, 0, buffer.getNumSamples()); 
-    float inputLevelDb = inputLevel > 0.0f ? juce::Decibels::gainToDecibels(inputLevel) : -100.0f;
-    lastInputLevel.store(inputLevelDb, std::memory_order_relaxed);
+    // Changes past the end of the block still apply, from the next one on.
+    for (; nextChange < numParameterChanges; ++nextChange)
+        applyParameterChange(parameterChanges[(size_t)nextChange]);
 
-    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
-        buffer.clear(i, 0, buffer.getNumSamples());
+    numParameterChanges = 0;
+
+    chain.outputMeter.process(buffer.getArrayOfReadPointers(), totalNumOutputChannels, 0, numSamples);
+
+   #if ! ONECOMP_HEADLESS
+    if (visualising)
+        waveformHistory.pushOutput(buffer.getArrayOfReadPointers(), totalNumOutputChannels, numSamples);
+   #endif
+
+    // The level sums cover every channel, so the readouts are the mean power.
+    storeLevels(levels.input, levels.output, numLevelSamples * juce::jmax(1, totalNumInputChannels));
+}
+
+// One stretch of the block with the same parameter values. Adds the
+// stretch's level sums to 'levels' and returns the number of samples per
+// channel they cover.
+template <typename SampleType>
+int OneCompAudioProcessor::processSubBlock(DspChain<SampleType>& chain, juce::AudioBuffer<SampleType>& buffer,
+                                           typename CompressorKernel<SampleType>::Levels& levels)
+{
+    auto totalNumInputChannels = getMainBusNumInputChannels();
+    auto numSamples = buffer.getNumSamples();
+
+    // Multiband mode runs at the base rate and replaces the single band
+    // kernel, including its lookahead and oversampling.
+    auto multiband = getNumBands() > 1;
+
+    if (multiband != multibandActive)
+    {
+        multibandActive = multiband;
+
+        if (multibandActive)
+        {
+            chain.multibandCompressor.reset();
+        }
+        else
+        {
+            chain.kernel.reset();
+            chain.keyFilter.reset();
+        }
+    }
+
+    updateOversampler(chain);
+
+    if (multibandActive)
+        chain.multibandCompressor.setParameters(getMultibandSnapshot());
+    else
+        chain.kernel.setParameters(getParameterSnapshot());
+
+    auto* activeOversampler = chain.activeOversampler;
+
+    auto meterFactor = multibandActive || activeOversampler == nullptr ? 1 : (int)activeOversampler->getOversamplingFactor();
+    gainReductionFifo.setSamplesPerPoint(GainReductionFifo::defaultSamplesPerPoint * meterFactor);
 
+    // Reporting latency calls back into the host, so it is left to the
+    // message thread when the lookahead or oversampling is automated. That
+    // thread polls for it: posting a message from here would take the
+    // message queue's lock.
+    auto latency = getCurrentLatency(chain);
+    reportedLatency.store(latency, std::memory_order_relaxed);
 
-    float threshold = *parameters.getRawParameterValue("threshold");
-    float ratio = *parameters.getRawParameterValue("ratio");
-    float attackTime = *parameters.getRawParameterValue("attack");
-    float releaseTime = *parameters.getRawParameterValue("release");
-    float makeupGain = *parameters.getRawParameterValue("gain");
+    auto* channels = buffer.getArrayOfWritePointers();
+    auto& bypass = chain.bypass;
+    bypass.setBypassed(bypassValue->load(std::memory_order_relaxed) >= 0.5f);
+    bypass.setDelay(latency);
+    bypass.pushDry(channels, totalNumInputChannels, numSamples);
 
-    compressor.setThreshold(*parameters.getRawParameterValue("threshold"));
-    compressor.setRatio(*parameters.getRawParameterValue("ratio"));
-    compressor.setAttack(*parameters.getRawParameterValue("attack"));
-    compressor.setRelease(*parameters.getRawParameterValue("release"));
+    typename CompressorKernel<SampleType>::Levels processed;
+    auto numProcessed = numSamples;
 
-    juce::dsp::AudioBlock<float> block(buffer);
-    juce::dsp::ProcessContextReplacing<float> context(block);
+    if (bypass.isBypassed())
+    {
+        // Nothing runs but the delayed dry signal; the readouts show it as
+        // both input and output.
+        chain.suspended = true;
+        bypass.process(channels, totalNumInputChannels, numSamples);
+        gainReductionFifo.pushConstant(1.0f, numSamples * meterFactor);
 
-    compressor.process(context);
+        for (int ch = 0; ch < totalNumInputChannels; ++ch)
+            for (int i = 0; i < numSamples; ++i)
+                processed.input += channels[ch][i] * channels[ch][i];
 
-    auto outputLevel = buffer.getRMSLevel(0, 0, buffer.getNumSamples());
+        levels.input += processed.input;
+        levels.output += processed.input;
+        return numSamples;
+    }
 
-    float gainReductionDb = outputLevel > 0 ? juce::Decibels::gainToDecibels(inputLevel / outputLevel) : 0.f;
+    if (chain.suspended)
+    {
+        // Coming out of bypass with stale state: start clean and stay dry
+        // until the delays have refilled.
+        chain.suspended = false;
+        chain.kernel.reset();
+        chain.keyFilter.reset();
+        chain.multibandCompressor.reset();
+        chain.makeupMeter.clear();
+        chain.autoMakeup.setCurrentAndTargetValue(1);
 
-    lastGainReduction.store(-gainReductionDb, std::memory_order_release);
+        if (activeOversampler != nullptr)
+            activeOversampler->reset();
+
+        bypass.holdDry(latency);
+    }
 
-    for (int channel = 0; channel < totalNumInputChannels; ++channel) {
-        auto* channelData = buffer.getWritePointer(channel);
-        for (int sample = 0; sample < buffer.getNumSamples(); ++sample) {
-            channelData[sample] *= juce::Decibels::decibelsToGain(makeupGain);
+    auto* key = multibandActive ? nullptr : prepareKey(chain, buffer, totalNumInputChannels, numSamples);
+    auto oversamplerLatency = latency - chain.kernel.getLatencySamples();
+
+    // Silent blocks are zeroed by processSilence() and leave the levels at
+    // zero. Whether a block counts as silent depends on where the host's
+    // blocks start and end, so offline renders always process in full and
+    // come out the same at any block size.
+    auto skipSilence = ! isNonRealtime();
+
+    if (multibandActive)
+    {
+        if (! (skipSilence && chain.multibandCompressor.processSilence(channels, totalNumInputChannels, numSamples)))
+            processed = chain.multibandCompressor.process(channels, totalNumInputChannels, numSamples);
+    }
+    else if (! (skipSilence && chain.kernel.processSilence(channels, totalNumInputChannels, numSamples, key, oversamplerLatency)))
+    {
+        if (activeOversampler == nullptr)
+        {
+            processed = chain.kernel.process(channels, totalNumInputChannels, numSamples, key);
+        }
+        else
+        {
+            juce::dsp::AudioBlock<SampleType> block(channels, (size_t)totalNumInputChannels, (size_t)numSamples);
+            auto upsampled = activeOversampler->processSamplesUp(block);
+
+            for (int ch = 0; ch < totalNumInputChannels; ++ch)
+                chain.channelPointers[(size_t)ch] = upsampled.getChannelPointer((size_t)ch);
+
+            numProcessed = (int)upsampled.getNumSamples();
+            processed = chain.kernel.process(chain.channelPointers.data(), totalNumInputChannels, numProcessed, key);
+            activeOversampler->processSamplesDown(block);
         }
     }
 
-    auto outputLevel2 = buffer.getRMSLevel(0, 0, buffer.getNumSamples());
-    float outputLevelDb = outputLevel2 > 0.0f ? juce::Decibels::gainToDecibels(outputLevel2) : -100.0f;
+    applyAutoMakeup(chain, channels, totalNumInputChannels, numSamples, processed);
+    bypass.process(channels, totalNumInputChannels, numSamples);
+
+    levels.input += processed.input;
+    levels.compressed += processed.compressed;
+    levels.output += processed.output;
+    return numProcessed;
+}
+
+// Brings the wet signal's short-term loudness to the target. This measures
+// the signal before the gain rather than after it, so there is no loop to
+// keep stable. The gain only moves on the meter's 100 ms steps, counted
+// from when auto makeup was switched on, so offline renders still come out
+// the same at any block size. It holds while the signal is below the absolute gate,
+// so pauses do not pull it up.
+template <typename SampleType>
+void OneCompAudioProcessor::applyAutoMakeup(DspChain<SampleType>& chain, SampleType* const* channels, int numChannels,
+                                            int numSamples, typename CompressorKernel<SampleType>::Levels& processed) noexcept
+{
+    auto enabled = autoMakeupValue->load(std::memory_order_relaxed) >= 0.5f;
+    auto& gain = chain.autoMakeup;
+
+    if (enabled != chain.autoMakeupActive)
+    {
+        chain.autoMakeupActive = enabled;
+        chain.makeupMeter.clear();
+        gain.setCurrentAndTargetValue(1);
+        autoMakeupGainDb.store(0.0f, std::memory_order_relaxed);
+    }
+
+    if (! enabled)
+        return;
+
+    auto& meter = chain.makeupMeter;
+    auto target = (double)loudnessTargetValue->load(std::memory_order_relaxed);
+    auto before = 0.0, after = 0.0;
+
+    for (int done = 0; done < numSamples;)
+    {
+        auto count = juce::jmin(numSamples - done, meter.getSamplesUntilStep());
+        auto loudness = meter.getShortTermLoudness();
+
+        if (loudness > LoudnessMeterBase::absoluteGate)
+        {
+            auto gainDb = juce::jlimit(-(double)maxAutoMakeupDb, (double)maxAutoMakeupDb, target - loudness);
+            gain.setTargetValue((SampleType)juce::Decibels::decibelsToGain(gainDb));
+        }
+
+        meter.process(channels, numChannels, done, count);
+
+        for (int i = done; i < done + count; ++i)
+        {
+            auto g = gain.getNextValue();
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto& sample = channels[ch][i];
+                before += (double)(sample * sample);
+                sample *= g;
+                after += (double)(sample * sample);
+            }
+        }
+
+        done += count;
+    }
+
+    // The kernel's output sum may be at the oversampled rate, so it is
+    // scaled rather than replaced.
+    if (before > 0.0)
+        processed.output *= (SampleType)(after / before);
+
+    autoMakeupGainDb.store(juce::Decibels::gainToDecibels((float)gain.getCurrentValue()), std::memory_order_relaxed);
+}
+
+void OneCompAudioProcessor::storeLevels(double inputSumOfSquares, double outputSumOfSquares, int numSamples) noexcept
+{
+    auto inputLevel = (float)CompressorKernelBase::toRMS(inputSumOfSquares, numSamples);
+    float inputLevelDb = inputLevel > 0.0f ? juce::Decibels::gainToDecibels(inputLevel) : -100.0f;
+    lastInputLevel.store(inputLevelDb, std::memory_order_relaxed);
+
+    auto outputLevel = (float)CompressorKernelBase::toRMS(outputSumOfSquares, numSamples);
+    float outputLevelDb = outputLevel > 0.0f ? juce::Decibels::gainToDecibels(outputLevel) : -100.0f;
     lastOutputLevel.store(outputLevelDb, std::memory_order_release);
+}
 
+CompressorKernelBase::Parameters OneCompAudioProcessor::getParameterSnapshot() const noexcept
+{
+    CompressorKernelBase::Parameters snapshot;
+    snapshot.inputGainDb = inputValue->load(std::memory_order_relaxed);
+    snapshot.makeupGainDb = gainValue->load(std::memory_order_relaxed);
+    snapshot.thresholdDb = thresholdValue->load(std::memory_order_relaxed);
+    snapshot.ratio = ratioValue->load(std::memory_order_relaxed);
+    snapshot.attackMs = attackValue->load(std::memory_order_relaxed);
+    snapshot.releaseMs = releaseValue->load(std::memory_order_relaxed);
+    snapshot.autoAttack = autoAttackValue->load(std::memory_order_relaxed) >= 0.5f;
+    snapshot.autoRelease = autoReleaseValue->load(std::memory_order_relaxed) >= 0.5f;
+    snapshot.lookaheadMs = lookaheadValue->load(std::memory_order_relaxed);
+    snapshot.kneeDb = kneeValue->load(std::memory_order_relaxed);
+    snapshot.detector = (LevelDetectorBase::Mode)juce::jlimit(0, 2, (int)detectorValue->load(std::memory_order_relaxed));
+    snapshot.rmsWindowMs = rmsWindowValue->load(std::memory_order_relaxed);
+    snapshot.link = (CompressorKernelBase::LinkMode)juce::jlimit(0, 3, (int)linkValue->load(std::memory_order_relaxed));
+    return snapshot;
 }
 
 bool OneCompAudioProcessor::hasEditor() const
 {
+#if ONECOMP_HEADLESS
+    return false;
+#else
     return true; 
+#endif
 }
 
 juce::AudioProcessorEditor* OneCompAudioProcessor::createEditor()
 {
+#if ONECOMP_HEADLESS
+    return nullptr;
+#else
     return new OneCompAudioProcessorEditor(*this);
+#endif
 }
 
 void OneCompAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
-    auto state = parameters.copyState();
-    std::unique_ptr<juce::XmlElement> xml(state.createXml());
-    copyXmlToBinary(*xml, destData);
+    compactState->save(destData);
 }
 
 void OneCompAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
+    auto size = (size_t)juce::jmax(0, sizeInBytes);
+
+    if (CompactState::isCompactState(data, size))
+    {
+        compactState->load(data, size);
+        return;
+    }
+
+    // Sessions saved before the compact format hold the parameter tree as XML.
     std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
 
     if (xmlState.get() != nullptr) {
@@ -259,13 +891,134 @@ void OneCompAudioProcessor::setStateInformation(const void* data, int sizeInByte
     }
 }
 
+MultibandCompressorBase::Parameters OneCompAudioProcessor::getMultibandSnapshot() const noexcept
+{
+    MultibandCompressorBase::Parameters snapshot;
+    snapshot.numBands = getNumBands();
+    snapshot.inputGainDb = inputValue->load(std::memory_order_relaxed);
+    snapshot.makeupGainDb = gainValue->load(std::memory_order_relaxed);
+    snapshot.kneeDb = kneeValue->load(std::memory_order_relaxed);
+    snapshot.autoAttack = autoAttackValue->load(std::memory_order_relaxed) >= 0.5f;
+    snapshot.autoRelease = autoReleaseValue->load(std::memory_order_relaxed) >= 0.5f;
+
+    for (size_t i = 0; i < crossoverValues.size(); ++i)
+        snapshot.crossoverHz[i] = crossoverValues[i]->load(std::memory_order_relaxed);
+
+    for (size_t band = 0; band < bandValues.size(); ++band)
+    {
+        auto& values = bandValues[band];
+        auto& b = snapshot.bands[band];
+        b.thresholdDb = values.threshold->load(std::memory_order_relaxed);
+        b.ratio = values.ratio->load(std::memory_order_relaxed);
+        b.attackMs = values.attack->load(std::memory_order_relaxed);
+        b.releaseMs = values.release->load(std::memory_order_relaxed);
+        b.makeupGainDb = values.gain->load(std::memory_order_relaxed);
+    }
+
+    return snapshot;
+}
+
+KeyFilterBase::Parameters OneCompAudioProcessor::getKeyFilterSnapshot() const noexcept
+{
+    KeyFilterBase::Parameters snapshot;
+    snapshot.highPassHz = keyHighPassValue->load(std::memory_order_relaxed);
+    snapshot.lowPassHz = keyLowPassValue->load(std::memory_order_relaxed);
+    snapshot.tiltDb = keyTiltValue->load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+// Returns the detector key for this block, or nullptr when the detector should
+// follow the main input unchanged. An unfiltered external sidechain is passed
+// through by pointer; only filtering writes into keyBuffer.
+template <typename SampleType>
+const SampleType* const* OneCompAudioProcessor::prepareKey(DspChain<SampleType>& chain, juce::AudioBuffer<SampleType>& buffer,
+                                                           int numChannels, int numSamples) noexcept
+{
+    auto& keyFilter = chain.keyFilter;
+    auto& keyBuffer = chain.keyBuffer;
+    keyFilter.setParameters(getKeyFilterSnapshot());
+
+    auto numSidechainChannels = getBusCount(true) > 1 && getBus(true, 1)->isEnabled() ? getChannelCountOfBus(true, 1) : 0;
+    auto useSidechain = sidechainValue->load(std::memory_order_relaxed) > 0.5f && numSidechainChannels > 0;
+
+    if (! useSidechain && ! keyFilter.isActive())
+        return nullptr;
+
+    // processChain never passes more than the prepared block size.
+    jassert(numSamples <= keyBuffer.getNumSamples());
+
+    auto sidechain = getBusBuffer(buffer, true, 1);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* source = useSidechain ? sidechain.getReadPointer(juce::jmin(ch, numSidechainChannels - 1))
+                                    : buffer.getReadPointer(ch);
+
+        if (keyFilter.isActive())
+        {
+            keyFilter.process(ch, source, keyBuffer.getWritePointer(ch), numSamples);
+            source = keyBuffer.getReadPointer(ch);
+        }
+
+        chain.keyPointers[(size_t)ch] = source;
+    }
+
+    return chain.keyPointers.data();
+}
+
+int OneCompAudioProcessor::getNumBands() const noexcept
+{
+    return juce::jlimit(1, MultibandCompressorBase::maxBands, (int)bandsValue->load(std::memory_order_relaxed) + 1);
+}
+
+template <typename SampleType>
+void OneCompAudioProcessor::updateOversampler(DspChain<SampleType>& chain) noexcept
+{
+    auto order = juce::jlimit(0, maxOversamplingOrder, (int)oversamplingValue->load(std::memory_order_relaxed));
+    auto filter = juce::jlimit(0, 1, (int)oversamplingFilterValue->load(std::memory_order_relaxed));
+    auto* wanted = order == 0 ? nullptr : chain.oversamplers[(size_t)(filter * maxOversamplingOrder + order - 1)].get();
+
+    if (wanted == chain.activeOversampler)
+        return;
+
+    chain.activeOversampler = wanted;
+
+    if (wanted != nullptr)
+        wanted->reset();
+
+    chain.kernel.setOversamplingFactor(1 << order);
+}
+
+template <typename SampleType>
+int OneCompAudioProcessor::getCurrentLatency(const DspChain<SampleType>& chain) const noexcept
+{
+    if (multibandActive)
+        return 0;
+
+    auto* oversampler = chain.activeOversampler;
+    auto oversamplerLatency = oversampler != nullptr ? juce::roundToInt(oversampler->getLatencyInSamples()) : 0;
+    return chain.kernel.getLatencySamples() + oversamplerLatency;
+}
+
+void OneCompAudioProcessor::timerCallback()
+{
+    auto latency = reportedLatency.load(std::memory_order_relaxed);
+
+    if (latency != getLatencySamples())
+        setLatencySamples(latency);
+}
+
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
 {
     return new OneCompAudioProcessor();
 }
 
-float OneCompAudioProcessor::getGainReduction() const {
-    return lastGainReduction.load(std::memory_order_relaxed); 
+GainReductionFifo& OneCompAudioProcessor::getGainReductionFifo() noexcept {
+    return gainReductionFifo;
+}
+
+WaveformHistory& OneCompAudioProcessor::getWaveformHistory() noexcept {
+    return waveformHistory;
 }
 
 float OneCompAudioProcessor::getInputLevel() const {
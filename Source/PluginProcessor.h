@@ -1,8 +1,25 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "CompressorKernel.h"
+#include "MultibandCompressor.h"
+#include "KeyFilter.h"
+#include "GainReductionFifo.h"
+#include "WaveformHistory.h"
+#include "BypassCrossfade.h"
+#include "CompactState.h"
+#include "PresetBank.h"
+#include "RealtimeAudit.h"
+#include "ProcessStats.h"
+#include "LoudnessMeter.h"
 
-class OneCompAudioProcessor : public juce::AudioProcessor
+// Set by the offline tools, which link the processor without the editor,
+// its binary resources or the plugin wrapper.
+#ifndef ONECOMP_HEADLESS
+ #define ONECOMP_HEADLESS 0
+#endif
+
+class OneCompAudioProcessor : public juce::AudioProcessor, private juce::Timer
 {
 public:
     OneCompAudioProcessor();
@@ -15,6 +32,9 @@ public:
     bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
 #endif
     void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock(juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
+    juce::AudioProcessorParameter* getBypassParameter() const override;
 
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override;
@@ -35,6 +55,32 @@ public:
     void getStateInformation(juce::MemoryBlock& destData) override;
     void setStateInformation(const void* data, int sizeInBytes) override;
 
+    // Saves the current settings as a user preset and selects it.
+    bool savePreset(const juce::String& name);
+
+    // Sample-accurate automation for callers that are the host themselves,
+    // such as the render tool: JUCE's plugin wrappers apply automation at
+    // the start of each block. Queues a change to the parameter at
+    // 'parameterIndex' in getParameters(), to the normalised 'value', at
+    // 'sampleOffset' in the next block, which is split there. Call on the
+    // audio thread before processBlock(). Returns false if the queue is full.
+    static constexpr int maxParameterChanges = 2048;
+    bool addParameterChange(int sampleOffset, int parameterIndex, float value) noexcept;
+
+    // EBU R128 loudness of the output since it was last reset, and the gain
+    // auto makeup is adding. All three are safe from any thread.
+    LoudnessMeterBase::Snapshot getLoudness() const noexcept;
+    float getAutoMakeupGain() const noexcept;
+    void resetLoudness() noexcept;
+
+    static constexpr float maxAutoMakeupDb = 24.0f;
+
+   #if ONECOMP_PROCESS_STATS
+    // processBlock() timing for this instance. Both are safe from any thread.
+    ProcessStats::Snapshot getProcessStats() const noexcept;
+    void resetProcessStats() noexcept;
+   #endif
+
     juce::AudioParameterFloat* threshold;
     juce::AudioParameterFloat* ratio;
     juce::AudioParameterFloat* attack;
@@ -44,14 +90,143 @@ public:
     juce::AudioProcessorValueTreeState parameters;
 
    
-    float getGainReduction() const;
+    GainReductionFifo& getGainReductionFifo() noexcept;
+    WaveformHistory& getWaveformHistory() noexcept;
     float getInputLevel() const; 
     float getOutputLevel() const; 
 
 private:
-    juce::dsp::Compressor<float> compressor;
+    static constexpr int maxOversamplingOrder = 3;
+    static constexpr int maxMainChannels = 12;
+
+    // Everything on the audio path that depends on the sample type. There is
+    // one chain per precision; prepareToPlay() prepares only the one the host
+    // will use.
+    template <typename SampleType>
+    struct DspChain
+    {
+        CompressorKernel<SampleType> kernel;
+
+        // Indexed by filter type * maxOversamplingOrder + order - 1.
+        std::array<std::unique_ptr<juce::dsp::Oversampling<SampleType>>, 2 * maxOversamplingOrder> oversamplers;
+        juce::dsp::Oversampling<SampleType>* activeOversampler = nullptr;
+        std::vector<SampleType*> channelPointers;
+
+        KeyFilter<SampleType> keyFilter;
+        juce::AudioBuffer<SampleType> keyBuffer;
+        std::vector<const SampleType*> keyPointers;
+
+        MultibandCompressor<SampleType> multibandCompressor;
+
+        // Auto makeup measures the wet signal before its gain; the output
+        // meter measures what leaves the plugin.
+        LoudnessMeter<SampleType> makeupMeter;
+        juce::SmoothedValue<SampleType, juce::ValueSmoothingTypes::Multiplicative> autoMakeup;
+        bool autoMakeupActive = false;
+        LoudnessMeter<SampleType> outputMeter;
+
+        BypassCrossfade<SampleType> bypass;
+        bool suspended = false; // fully bypassed, nothing above has run
+    };
+
+    struct ParameterChange
+    {
+        int sampleOffset;
+        int parameterIndex;
+        float value;
+    };
+
+    CompressorKernelBase::Parameters getParameterSnapshot() const noexcept;
+    MultibandCompressorBase::Parameters getMultibandSnapshot() const noexcept;
+    KeyFilterBase::Parameters getKeyFilterSnapshot() const noexcept;
+    int getNumBands() const noexcept;
+    void storeLevels(double inputSumOfSquares, double outputSumOfSquares, int numSamples) noexcept;
+    void applyParameterChange(const ParameterChange& change) noexcept;
+    void timerCallback() override;
+
+    template <typename SampleType>
+    void prepareChain(DspChain<SampleType>& chain, double sampleRate, int samplesPerBlock);
+    template <typename SampleType>
+    void processChain(DspChain<SampleType>& chain, juce::AudioBuffer<SampleType>& buffer);
+    template <typename SampleType>
+    int processSubBlock(DspChain<SampleType>& chain, juce::AudioBuffer<SampleType>& buffer,
+                        typename CompressorKernel<SampleType>::Levels& levels);
+    template <typename SampleType>
+    void applyAutoMakeup(DspChain<SampleType>& chain, SampleType* const* channels, int numChannels, int numSamples,
+                         typename CompressorKernel<SampleType>::Levels& processed) noexcept;
+    template <typename SampleType>
+    const SampleType* const* prepareKey(DspChain<SampleType>& chain, juce::AudioBuffer<SampleType>& buffer,
+                                        int numChannels, int numSamples) noexcept;
+    template <typename SampleType>
+    void updateOversampler(DspChain<SampleType>& chain) noexcept;
+    template <typename SampleType>
+    int getCurrentLatency(const DspChain<SampleType>& chain) const noexcept;
+
+    DspChain<float> floatChain;
+    DspChain<double> doubleChain;
+
+    GainReductionFifo gainReductionFifo;
+    WaveformHistory waveformHistory;
+    bool multibandActive = false;
+    int maxBlockSize = 0; // as prepared; longer blocks are processed in pieces
+
+    // Cached once in the constructor so the audio thread never looks
+    // parameters up by name.
+    std::atomic<float>* thresholdValue = nullptr;
+    std::atomic<float>* ratioValue = nullptr;
+    std::atomic<float>* attackValue = nullptr;
+    std::atomic<float>* releaseValue = nullptr;
+    std::atomic<float>* gainValue = nullptr;
+    std::atomic<float>* inputValue = nullptr;
+    std::atomic<float>* lookaheadValue = nullptr;
+    std::atomic<float>* kneeValue = nullptr;
+    std::atomic<float>* detectorValue = nullptr;
+    std::atomic<float>* rmsWindowValue = nullptr;
+    std::atomic<float>* linkValue = nullptr;
+    std::atomic<float>* oversamplingValue = nullptr;
+    std::atomic<float>* oversamplingFilterValue = nullptr;
+    std::atomic<float>* bandsValue = nullptr;
+    std::atomic<float>* sidechainValue = nullptr;
+    std::atomic<float>* keyHighPassValue = nullptr;
+    std::atomic<float>* keyLowPassValue = nullptr;
+    std::atomic<float>* keyTiltValue = nullptr;
+    std::atomic<float>* autoAttackValue = nullptr;
+    std::atomic<float>* autoReleaseValue = nullptr;
+    std::atomic<float>* bypassValue = nullptr;
+    std::atomic<float>* autoMakeupValue = nullptr;
+    std::atomic<float>* loudnessTargetValue = nullptr;
+
+    struct BandValues
+    {
+        std::atomic<float>* threshold = nullptr;
+        std::atomic<float>* ratio = nullptr;
+        std::atomic<float>* attack = nullptr;
+        std::atomic<float>* release = nullptr;
+        std::atomic<float>* gain = nullptr;
+    };
+
+    std::array<std::atomic<float>*, MultibandCompressorBase::maxBands - 1> crossoverValues{};
+    std::array<BandValues, MultibandCompressorBase::maxBands> bandValues;
+
+    std::atomic<int> reportedLatency{ 0 };
+    std::atomic<float> autoMakeupGainDb{ 0.0f };
+
+    // Audio thread only. Kept in sample order, with equal offsets in the
+    // order they were added.
+    std::array<ParameterChange, maxParameterChanges> parameterChanges;
+    int numParameterChanges = 0;
+
+    // Indexed like getParameters().
+    std::vector<std::atomic<float>*> rawParameterValues;
+
+   #if ONECOMP_PROCESS_STATS
+    ProcessStats processStats;
+   #endif
+
+    std::unique_ptr<CompactState> compactState;
+    juce::SharedResourcePointer<PresetBank> presetBank;
+    int currentProgram = 0;
 
-    std::atomic<float> lastGainReduction{ 0.0f };
     std::atomic<float> lastInputLevel{ 0.0f }; 
     std::atomic<float> lastOutputLevel{ 0.0f }; 
   
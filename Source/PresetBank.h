@@ -0,0 +1,178 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "CompactState.h"
+
+// The plugin's programs: the factory presets below, then the user presets in
+// getUserDirectory() sorted by name. A user preset is one compact state (see
+// CompactState) per file. Loading maps the file and hands the mapping
+// straight to the loader, so nothing is read into a buffer or parsed.
+//
+// One bank is shared by every instance in the process through a
+// juce::SharedResourcePointer, and the directory is scanned on first use
+// rather than by each instance a session restores. Message thread only.
+class PresetBank
+{
+public:
+    static constexpr const char* fileExtension = ".ocpreset";
+
+    static juce::File getUserDirectory()
+    {
+        return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+            .getChildFile("oneComp")
+            .getChildFile("Presets");
+    }
+
+    int getNumPresets()
+    {
+        scanIfNeeded();
+        return (int)(getFactoryPresets().size() + userPresets.size());
+    }
+
+    bool isFactoryPreset(int index) const noexcept
+    {
+        return juce::isPositiveAndBelow(index, (int)getFactoryPresets().size());
+    }
+
+    juce::String getName(int index)
+    {
+        scanIfNeeded();
+
+        if (isFactoryPreset(index))
+            return getFactoryPresets()[(size_t)index].name;
+
+        auto* user = getUserPreset(index);
+        return user != nullptr ? user->name : juce::String();
+    }
+
+    // Calls loader(data, size) with the preset's state and returns its result.
+    template <typename Loader>
+    bool load(int index, Loader&& loader)
+    {
+        scanIfNeeded();
+
+        if (isFactoryPreset(index))
+        {
+            auto& state = getFactoryPresets()[(size_t)index].state;
+            return loader(state.getData(), state.getSize());
+        }
+
+        auto* user = getUserPreset(index);
+
+        if (user == nullptr)
+            return false;
+
+        juce::MemoryMappedFile mapped(user->file, juce::MemoryMappedFile::readOnly);
+        return mapped.getData() != nullptr && loader(mapped.getData(), mapped.getSize());
+    }
+
+    // Writes a user preset, replacing any of the same name. Returns its
+    // index, or -1 if the file could not be written.
+    int save(const juce::String& name, const juce::MemoryBlock& state)
+    {
+        auto file = getUserDirectory().getChildFile(juce::File::createLegalFileName(name) + fileExtension);
+
+        if (! file.getParentDirectory().createDirectory() || ! file.replaceWithData(state.getData(), state.getSize()))
+            return -1;
+
+        rescan();
+        return indexOf(file);
+    }
+
+    // Factory presets cannot be renamed.
+    bool rename(int index, const juce::String& newName)
+    {
+        auto* user = getUserPreset(index);
+
+        if (user == nullptr || newName.trim().isEmpty())
+            return false;
+
+        auto target = user->file.getSiblingFile(juce::File::createLegalFileName(newName.trim()) + fileExtension);
+
+        if (target.exists() || ! user->file.moveFileTo(target))
+            return false;
+
+        rescan();
+        return true;
+    }
+
+    void rescan()
+    {
+        userPresets.clear();
+
+        for (auto& file : getUserDirectory().findChildFiles(juce::File::findFiles, false, juce::String("*") + fileExtension))
+            userPresets.push_back({ file.getFileNameWithoutExtension(), file });
+
+        std::sort(userPresets.begin(), userPresets.end(), [](const UserPreset& a, const UserPreset& b)
+        {
+            return a.name.compareNatural(b.name) < 0;
+        });
+
+        scanned = true;
+    }
+
+private:
+    struct FactoryPreset
+    {
+        juce::String name;
+        juce::MemoryBlock state;
+    };
+
+    struct UserPreset
+    {
+        juce::String name;
+        juce::File file;
+    };
+
+    // Parameters a preset leaves out get their defaults.
+    static const std::vector<FactoryPreset>& getFactoryPresets()
+    {
+        static const std::vector<FactoryPreset> presets
+        {
+            { "Default", CompactState::encode({}) },
+            { "Gentle Leveler", CompactState::encode({ { "threshold", -24.0f }, { "ratio", 2.0f }, { "attack", 20.0f },
+                                                       { "release", 250.0f }, { "knee", 12.0f }, { "detector", 1.0f },
+                                                       { "rmsWindow", 20.0f }, { "link", 2.0f }, { "gain", 4.0f } }) },
+            { "Vocal", CompactState::encode({ { "threshold", -18.0f }, { "ratio", 4.0f }, { "attack", 5.0f },
+                                              { "release", 80.0f }, { "knee", 6.0f }, { "detector", 1.0f },
+                                              { "link", 1.0f }, { "keyHighPass", 100.0f }, { "gain", 6.0f } }) },
+            { "Drum Bus", CompactState::encode({ { "threshold", -12.0f }, { "ratio", 4.0f }, { "attack", 30.0f },
+                                                 { "release", 100.0f }, { "knee", 3.0f }, { "link", 1.0f },
+                                                 { "keyHighPass", 80.0f }, { "gain", 3.0f } }) },
+            { "Brickwall", CompactState::encode({ { "threshold", -1.0f }, { "ratio", 25.0f }, { "attack", 0.1f },
+                                                  { "release", 50.0f }, { "lookahead", 5.0f }, { "detector", 2.0f },
+                                                  { "link", 1.0f } }) },
+            { "Multiband Master", CompactState::encode({ { "bands", 2.0f }, { "crossover1", 150.0f }, { "crossover2", 4000.0f },
+                                                         { "link", 1.0f },
+                                                         { "band1Threshold", -18.0f }, { "band1Ratio", 2.0f }, { "band1Attack", 30.0f }, { "band1Release", 200.0f },
+                                                         { "band2Threshold", -16.0f }, { "band2Ratio", 1.8f }, { "band2Attack", 15.0f }, { "band2Release", 120.0f },
+                                                         { "band3Threshold", -14.0f }, { "band3Ratio", 2.0f }, { "band3Attack", 5.0f }, { "band3Release", 80.0f } }) }
+        };
+
+        return presets;
+    }
+
+    void scanIfNeeded()
+    {
+        if (! scanned)
+            rescan();
+    }
+
+    const UserPreset* getUserPreset(int index) const noexcept
+    {
+        index -= (int)getFactoryPresets().size();
+        return juce::isPositiveAndBelow(index, (int)userPresets.size()) ? &userPresets[(size_t)index] : nullptr;
+    }
+
+    int indexOf(const juce::File& file) const
+    {
+        for (size_t i = 0; i < userPresets.size(); ++i)
+            if (userPresets[i].file == file)
+                return (int)(getFactoryPresets().size() + i);
+
+        return -1;
+    }
+
+    std::vector<UserPreset> userPresets;
+    bool scanned = false;
+};
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Times processBlock() per plugin instance and shows it on the editor's
+// diagnostics page. Off by default in Release builds, where none of this
+// is compiled into the audio path.
+#ifndef ONECOMP_PROCESS_STATS
+ #define ONECOMP_PROCESS_STATS JUCE_DEBUG
+#endif
+
+// The audio thread is the only writer, so each counter is a relaxed load and
+// store rather than a read-modify-write, and a reader on another thread may
+// see a block counted in one field but not yet in the next. Block times go
+// into a histogram of quarter-octave buckets, so the p99 is the upper edge
+// of its bucket: within 19% of the true value, never below it.
+class ProcessStats
+{
+public:
+    struct Snapshot
+    {
+        juce::uint64 numBlocks = 0;
+        juce::uint64 numSamples = 0;
+        double minUs = 0.0;
+        double meanUs = 0.0;
+        double p99Us = 0.0;
+        double maxUs = 0.0;
+        double load = 0.0;           // processing time over the duration of the audio
+        double worstBlockLoad = 0.0; // the same for the slowest block against its own length
+        juce::uint64 numOverruns = 0; // blocks that took longer than they last
+    };
+
+    class Scope
+    {
+    public:
+        Scope(ProcessStats& s, int n) noexcept
+            : stats(s), numSamples(n), start(juce::Time::getHighResolutionTicks())
+        {
+        }
+
+        ~Scope()
+        {
+            stats.add(juce::Time::getHighResolutionTicks() - start, numSamples);
+        }
+
+    private:
+        ProcessStats& stats;
+        int numSamples;
+        juce::int64 start;
+
+        JUCE_DECLARE_NON_COPYABLE(Scope)
+    };
+
+    ProcessStats() noexcept
+        : secondsPerTick(1.0 / (double)juce::Time::getHighResolutionTicksPerSecond())
+    {
+    }
+
+    // Called from prepareToPlay(); the totals carry on across it.
+    void prepare(double newSampleRate) noexcept
+    {
+        sampleRate = newSampleRate;
+    }
+
+    // Audio thread only.
+    void add(juce::int64 ticks, int blockSamples) noexcept
+    {
+        if (resetRequested.load(std::memory_order_acquire))
+        {
+            resetRequested.store(false, std::memory_order_relaxed);
+            clear();
+        }
+
+        auto seconds = (double)ticks * secondsPerTick;
+        auto us = seconds * 1.0e6;
+        auto audioSeconds = (double)blockSamples / sampleRate;
+        auto blockLoad = blockSamples > 0 ? seconds / audioSeconds : 0.0;
+        auto isFirst = numBlocks.load(std::memory_order_relaxed) == 0;
+
+        increment(numBlocks, 1);
+        increment(numSamples, blockSamples);
+        increment(totalUs, us);
+        increment(totalAudioUs, audioSeconds * 1.0e6);
+        increment(histogram[(size_t)getBucket(us)], 1);
+
+        if (isFirst || us < minUs.load(std::memory_order_relaxed))
+            minUs.store(us, std::memory_order_relaxed);
+
+        if (us > maxUs.load(std::memory_order_relaxed))
+            maxUs.store(us, std::memory_order_relaxed);
+
+        if (blockLoad > worstBlockLoad.load(std::memory_order_relaxed))
+            worstBlockLoad.store(blockLoad, std::memory_order_relaxed);
+
+        if (blockLoad > 1.0)
+            increment(numOverruns, 1);
+    }
+
+    // Any thread. Takes effect at the start of the next block.
+    void reset() noexcept
+    {
+        resetRequested.store(true, std::memory_order_release);
+    }
+
+    // Any thread.
+    Snapshot getSnapshot() const noexcept
+    {
+        Snapshot s;
+        s.numBlocks = numBlocks.load(std::memory_order_relaxed);
+
+        if (s.numBlocks == 0 || resetRequested.load(std::memory_order_relaxed))
+            return {};
+
+        s.numSamples = numSamples.load(std::memory_order_relaxed);
+        s.minUs = minUs.load(std::memory_order_relaxed);
+        s.maxUs = maxUs.load(std::memory_order_relaxed);
+        s.meanUs = totalUs.load(std::memory_order_relaxed) / (double)s.numBlocks;
+        s.worstBlockLoad = worstBlockLoad.load(std::memory_order_relaxed);
+        s.numOverruns = numOverruns.load(std::memory_order_relaxed);
+
+        auto audioUs = totalAudioUs.load(std::memory_order_relaxed);
+        s.load = audioUs > 0.0 ? totalUs.load(std::memory_order_relaxed) / audioUs : 0.0;
+
+        juce::uint64 counts[numBuckets], total = 0;
+
+        for (int i = 0; i < numBuckets; ++i)
+            total += counts[i] = histogram[(size_t)i].load(std::memory_order_relaxed);
+
+        auto target = total - total / 100;
+        juce::uint64 below = 0;
+
+        for (int i = 0; i < numBuckets; ++i)
+        {
+            below += counts[i];
+
+            if (below >= target)
+            {
+                s.p99Us = juce::jmin(s.maxUs, getBucketTop(i));
+                break;
+            }
+        }
+
+        return s;
+    }
+
+private:
+    static constexpr int numBuckets = 96;
+    static constexpr int bucketsPerOctave = 4;
+    static constexpr double lowestBucketUs = 0.0625; // the top bucket starts at about 1 s
+
+    static int getBucket(double us) noexcept
+    {
+        if (us <= lowestBucketUs)
+            return 0;
+
+        return juce::jmin(numBuckets - 1, (int)(std::log2(us / lowestBucketUs) * bucketsPerOctave));
+    }
+
+    static double getBucketTop(int bucket) noexcept
+    {
+        return lowestBucketUs * std::exp2((double)(bucket + 1) / bucketsPerOctave);
+    }
+
+    template <typename Type, typename Amount>
+    static void increment(std::atomic<Type>& counter, Amount amount) noexcept
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + (Type)amount, std::memory_order_relaxed);
+    }
+
+    void clear() noexcept
+    {
+        for (auto& bucket : histogram)
+            bucket.store(0, std::memory_order_relaxed);
+
+        for (auto* counter : { &numBlocks, &numSamples, &numOverruns })
+            counter->store(0, std::memory_order_relaxed);
+
+        for (auto* value : { &totalUs, &totalAudioUs, &minUs, &maxUs, &worstBlockLoad })
+            value->store(0.0, std::memory_order_relaxed);
+    }
+
+    const double secondsPerTick;
+    double sampleRate = 44100.0;
+
+    std::atomic<juce::uint64> numBlocks{ 0 }, numSamples{ 0 }, numOverruns{ 0 };
+    std::atomic<double> totalUs{ 0.0 }, totalAudioUs{ 0.0 }, minUs{ 0.0 }, maxUs{ 0.0 }, worstBlockLoad{ 0.0 };
+    std::array<std::atomic<juce::uint64>, numBuckets> histogram{};
+    std::atomic<bool> resetRequested{ false };
+};
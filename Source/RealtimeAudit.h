@@ -0,0 +1,43 @@
+#pragma once
+
+// Real-time safety audit. Built with ONECOMP_RT_AUDIT=1, as the oneCompAudit
+// tool is, processBlock() marks its thread for the duration of the call and
+// the allocator and mutex hooks linked into the tool report every call made
+// while the mark is set. In any other build the marker is an empty struct.
+#ifndef ONECOMP_RT_AUDIT
+ #define ONECOMP_RT_AUDIT 0
+#endif
+
+namespace RealtimeAudit
+{
+   #if ONECOMP_RT_AUDIT
+    // A depth rather than a flag, so nested marks unwind correctly.
+    inline int& depth() noexcept
+    {
+        static thread_local int value = 0;
+        return value;
+    }
+
+    inline bool isAudioThread() noexcept { return depth() > 0; }
+
+    struct ScopedAudioThread
+    {
+        ScopedAudioThread() noexcept { ++depth(); }
+        ~ScopedAudioThread() { --depth(); }
+    };
+
+    // Lifts the mark, for the hooks' own reporting.
+    struct ScopedSuspend
+    {
+        ScopedSuspend() noexcept : saved(depth()) { depth() = 0; }
+        ~ScopedSuspend() { depth() = saved; }
+
+        int saved;
+    };
+   #else
+    struct ScopedAudioThread
+    {
+        ScopedAudioThread() noexcept {}
+    };
+   #endif
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Tracks how long a processor's input has been silent, for the silence fast
+// paths. A block counts as silent when its peak, scaled by whatever gain the
+// caller applies, is below 'floor'. Skipping is allowed once the silence has
+// lasted long enough to flush the caller's delays.
+class SilenceGate
+{
+public:
+    // -120 dBFS, below the noise floor of 20-bit audio.
+    static constexpr float floor = 1.0e-6f;
+
+    template <typename SampleType>
+    static SampleType getPeak(const SampleType* const* channels, int numChannels, int numSamples) noexcept
+    {
+        SampleType peak = 0;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto range = juce::FloatVectorOperations::findMinAndMax(channels[ch], numSamples);
+            peak = juce::jmax(peak, -range.getStart(), range.getEnd());
+        }
+
+        return peak;
+    }
+
+    // Returns true if the block may be skipped: it is silent, and at least
+    // settleSamples of silence came before it.
+    bool update(double peak, int numSamples, int settleSamples) noexcept
+    {
+        if (peak >= floor)
+        {
+            silentSamples = 0;
+            return false;
+        }
+
+        auto settled = silentSamples >= settleSamples;
+        silentSamples = juce::jmin(silentSamples + numSamples, maxSilentSamples);
+        return settled;
+    }
+
+    void reset() noexcept { silentSamples = 0; }
+
+private:
+    static constexpr int maxSilentSamples = 1 << 30;
+    int silentSamples = 0;
+};
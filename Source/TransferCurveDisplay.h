@@ -0,0 +1,113 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "GainComputer.h"
+#include "FrameTimeStats.h"
+
+// The single band's static curve: detector level in against level out, in
+// dB, with a dot at the latest input peak and the gain actually applied to
+// it, so attack and release show as the dot leaving the curve. The curve is
+// built into a cached Path only when the threshold, ratio or knee change or
+// the display is resized; otherwise a frame repaints just the dot.
+class TransferCurveDisplay : public juce::Component {
+public:
+    static constexpr float rangeDb = -60.0f;
+
+    TransferCurveDisplay() {
+        setOpaque(true);
+    }
+
+    void setFrameStats(FrameTimeStats* stats) { frameStats = stats; }
+
+    void setCurve(float thresholdDb, float ratio, float kneeDb) {
+        if (thresholdDb == curveThreshold && ratio == curveRatio && kneeDb == curveKnee)
+            return;
+
+        curveThreshold = thresholdDb;
+        curveRatio = ratio;
+        curveKnee = kneeDb;
+        buildCurve();
+        repaint();
+    }
+
+    void setLevel(float inputDb, float gainDb) {
+        auto newDot = getDotBounds(inputDb, inputDb + gainDb);
+
+        if (newDot == dot)
+            return;
+
+        repaint(dot.getSmallestIntegerContainer().expanded(1));
+        repaint(newDot.getSmallestIntegerContainer().expanded(1));
+        dot = newDot;
+    }
+
+    void paint(juce::Graphics& g) override {
+        FrameTimeStats::Scope scope(frameStats, FrameTimeStats::paint);
+
+        auto area = getLocalBounds().toFloat();
+        g.fillAll(juce::Colours::black);
+
+        g.setColour(juce::Colours::white.withAlpha(0.15f));
+
+        for (auto db = 0.0f; db > rangeDb; db -= 12.0f) {
+            g.drawHorizontalLine(juce::roundToInt(toY(db)), area.getX(), area.getRight());
+            g.drawVerticalLine(juce::roundToInt(toX(db)), area.getY(), area.getBottom());
+        }
+
+        g.drawLine(toX(rangeDb), toY(rangeDb), toX(0.0f), toY(0.0f));
+
+        g.setColour(juce::Colours::green);
+        g.strokePath(curve, juce::PathStrokeType(2.0f));
+
+        if (! dot.isEmpty()) {
+            g.setColour(juce::Colours::yellow);
+            g.fillEllipse(dot);
+        }
+    }
+
+    void resized() override {
+        buildCurve();
+    }
+
+private:
+    float toX(float db) const {
+        return juce::jmap(juce::jlimit(rangeDb, 0.0f, db), rangeDb, 0.0f, 0.0f, (float)getWidth());
+    }
+
+    float toY(float db) const {
+        return juce::jmap(juce::jlimit(rangeDb, 0.0f, db), rangeDb, 0.0f, (float)getHeight(), 0.0f);
+    }
+
+    juce::Rectangle<float> getDotBounds(float inputDb, float outputDb) const {
+        if (inputDb <= rangeDb)
+            return {};
+
+        return juce::Rectangle<float>(7.0f, 7.0f).withCentre({ toX(inputDb), toY(outputDb) });
+    }
+
+    // One point per pixel, through the same gain computer the kernel uses.
+    void buildCurve() {
+        GainComputer<float> computer;
+        computer.setParameters(curveThreshold, curveRatio, curveKnee);
+        curve.clear();
+
+        for (int x = 0; x <= getWidth(); ++x) {
+            auto inputDb = juce::jmap((float)x, 0.0f, (float)juce::jmax(1, getWidth()), rangeDb, 0.0f);
+            auto gain = computer.getGain(juce::Decibels::decibelsToGain(inputDb, rangeDb * 2.0f));
+            auto y = toY(inputDb + juce::Decibels::gainToDecibels(gain, rangeDb * 2.0f));
+
+            if (x == 0)
+                curve.startNewSubPath((float)x, y);
+            else
+                curve.lineTo((float)x, y);
+        }
+    }
+
+    FrameTimeStats* frameStats = nullptr;
+    juce::Path curve;
+    juce::Rectangle<float> dot;
+
+    float curveThreshold = 0.0f;
+    float curveRatio = 1.0f;
+    float curveKnee = 0.0f;
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Hands whole frames from one writer thread to one reader thread. The writer
+// fills getWriteFrame() and publishes it; the reader picks up the newest
+// published frame and skips any it missed. Three frames rotate between the
+// two sides and a shared middle slot, so neither side ever waits, allocates
+// or sees a frame the other is using.
+template <typename Frame>
+class TripleBuffer
+{
+public:
+    // Writer only.
+    Frame& getWriteFrame() noexcept { return frames[(size_t)writeIndex]; }
+
+    void publish() noexcept
+    {
+        auto previous = middle.exchange(writeIndex | freshFlag, std::memory_order_acq_rel);
+        writeIndex = previous & indexMask;
+    }
+
+    // Reader only. Returns true if a frame was published since the last
+    // call, and makes it getReadFrame(). The read frame stays unchanged until
+    // the next call that returns true.
+    bool update() noexcept
+    {
+        if ((middle.load(std::memory_order_relaxed) & freshFlag) == 0)
+            return false;
+
+        auto previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & indexMask;
+        return true;
+    }
+
+    const Frame& getReadFrame() const noexcept { return frames[(size_t)readIndex]; }
+
+private:
+    static constexpr int indexMask = 3;
+    static constexpr int freshFlag = 4;
+
+    std::array<Frame, 3> frames{};
+    int writeIndex = 0;
+    int readIndex = 1;
+    std::atomic<int> middle{ 2 };
+};
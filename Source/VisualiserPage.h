@@ -0,0 +1,85 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "TransferCurveDisplay.h"
+#include "WaveformDisplay.h"
+
+// The transfer curve and the scrolling waveform of one instance, opened from
+// the View menu. Switches the processor's WaveformHistory on while it exists
+// and reads it at 30 Hz; frames only arrive while audio is processed, so an
+// idle page draws nothing.
+class VisualiserPage : public juce::Component, private juce::Timer
+{
+public:
+    VisualiserPage(OneCompAudioProcessor& p, FrameTimeStats* stats)
+        : processor(p), frameStats(stats)
+    {
+        thresholdValue = processor.parameters.getRawParameterValue("threshold");
+        ratioValue = processor.parameters.getRawParameterValue("ratio");
+        kneeValue = processor.parameters.getRawParameterValue("knee");
+        inputValue = processor.parameters.getRawParameterValue("input");
+
+        curve.setFrameStats(stats);
+        waveform.setFrameStats(stats);
+        addAndMakeVisible(curve);
+        addAndMakeVisible(waveform);
+
+        setSize(3 * margin + curveSize + WaveformHistory::numColumns, 2 * margin + curveSize);
+        processor.getWaveformHistory().setActive(true);
+        timerCallback();
+        startTimerHz(30);
+    }
+
+    ~VisualiserPage() override
+    {
+        processor.getWaveformHistory().setActive(false);
+    }
+
+    void paint(juce::Graphics& g) override
+    {
+        g.fillAll(getLookAndFeel().findColour(juce::ResizableWindow::backgroundColourId));
+    }
+
+    void resized() override
+    {
+        auto area = getLocalBounds().reduced(margin);
+        curve.setBounds(area.removeFromLeft(curveSize));
+        area.removeFromLeft(margin);
+        waveform.setBounds(area);
+    }
+
+private:
+    static constexpr int margin = 12;
+    static constexpr int curveSize = 200;
+
+    void timerCallback() override
+    {
+        FrameTimeStats::Scope scope(frameStats, FrameTimeStats::timer);
+
+        curve.setCurve(thresholdValue->load(), ratioValue->load(), kneeValue->load());
+
+        if (auto* frame = processor.getWaveformHistory().pull())
+        {
+            auto& newest = frame->columns.back();
+            auto peak = juce::jmax(std::abs(newest.inputMin), std::abs(newest.inputMax));
+            auto inputDb = juce::Decibels::gainToDecibels(peak, -100.0f) + inputValue->load();
+
+            waveform.addFrame(*frame);
+            curve.setLevel(inputDb, juce::Decibels::gainToDecibels(newest.minGain, -100.0f));
+        }
+    }
+
+    OneCompAudioProcessor& processor;
+    FrameTimeStats* frameStats;
+
+    std::atomic<float>* thresholdValue = nullptr;
+    std::atomic<float>* ratioValue = nullptr;
+    std::atomic<float>* kneeValue = nullptr;
+    std::atomic<float>* inputValue = nullptr;
+
+    TransferCurveDisplay curve;
+    WaveformDisplay waveform;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VisualiserPage)
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "WaveformHistory.h"
+#include "FrameTimeStats.h"
+
+// Scrolling input and output waveforms with the gain reduction traced over
+// them, one WaveformHistory column per pixel, newest on the right. Columns
+// are drawn into a cached image once, as they arrive: a new frame scrolls the
+// image and draws only the columns it adds, so the cost follows the audio
+// rather than the size of the display, and a stopped transport costs nothing.
+class WaveformDisplay : public juce::Component {
+public:
+    static constexpr float rangeDb = -24.0f; // gain reduction at the bottom edge
+
+    WaveformDisplay() {
+        setOpaque(true);
+    }
+
+    void setFrameStats(FrameTimeStats* stats) { frameStats = stats; }
+
+    // 'frame' must stay valid until the next call, as WaveformHistory::pull()
+    // guarantees, since a resize redraws from it.
+    void addFrame(const WaveformHistory::Frame& frame) {
+        auto numNew = frame.numFinished - numDrawn;
+        lastFrame = &frame;
+
+        if (! canvas.isValid())
+            return;
+
+        // A restarted history, or more new columns than fit, redraws it all.
+        if (frame.numFinished < numDrawn || numNew >= (juce::uint64)WaveformHistory::numColumns) {
+            redraw();
+            return;
+        }
+
+        if (numNew == 0)
+            return;
+
+        auto count = (int)numNew;
+        canvas.moveImageSection(0, 0, count, 0, canvas.getWidth() - count, canvas.getHeight());
+        drawColumns(WaveformHistory::numColumns - count);
+        numDrawn = frame.numFinished;
+        repaint();
+    }
+
+    void paint(juce::Graphics& g) override {
+        FrameTimeStats::Scope scope(frameStats, FrameTimeStats::paint);
+        g.drawImageAt(canvas, 0, 0);
+    }
+
+    void resized() override {
+        canvas = juce::Image(juce::Image::RGB, juce::jmax(1, getWidth()), juce::jmax(1, getHeight()), true);
+        redraw();
+    }
+
+private:
+    void redraw() {
+        juce::Graphics(canvas).fillAll(juce::Colours::black);
+
+        if (lastFrame != nullptr) {
+            drawColumns(0);
+            numDrawn = lastFrame->numFinished;
+        }
+
+        repaint();
+    }
+
+    // Draws the frame's columns from 'first' on at the right-hand end of the
+    // image, each over a cleared strip.
+    void drawColumns(int first) {
+        juce::Graphics g(canvas);
+        auto height = (float)canvas.getHeight();
+        auto centre = height * 0.5f;
+        auto offset = canvas.getWidth() - WaveformHistory::numColumns;
+
+        auto toY = [centre](float sample) { return centre - juce::jlimit(-1.0f, 1.0f, sample) * centre; };
+        auto toGainY = [height](float gain) {
+            auto db = juce::Decibels::gainToDecibels(gain, rangeDb * 2.0f);
+            return juce::jmap(juce::jlimit(rangeDb, 0.0f, db), 0.0f, rangeDb, 0.0f, height - 1.0f);
+        };
+
+        g.setColour(juce::Colours::black);
+        g.fillRect(offset + first, 0, WaveformHistory::numColumns - first, canvas.getHeight());
+
+        auto& columns = lastFrame->columns;
+        auto previousGainY = toGainY(columns[(size_t)juce::jmax(0, first - 1)].minGain);
+
+        for (int i = first; i < WaveformHistory::numColumns; ++i) {
+            auto& column = columns[(size_t)i];
+            auto x = offset + i;
+
+            if (x < 0)
+                continue;
+
+            g.setColour(juce::Colours::grey);
+            g.drawVerticalLine(x, toY(column.inputMax), toY(column.inputMin) + 1.0f);
+            g.setColour(juce::Colours::green);
+            g.drawVerticalLine(x, toY(column.outputMax), toY(column.outputMin) + 1.0f);
+
+            auto gainY = toGainY(column.minGain);
+            g.setColour(juce::Colours::red);
+            g.drawVerticalLine(x, juce::jmin(previousGainY, gainY), juce::jmax(previousGainY, gainY) + 1.0f);
+            previousGainY = gainY;
+        }
+    }
+
+    FrameTimeStats* frameStats = nullptr;
+    juce::Image canvas;
+    const WaveformHistory::Frame* lastFrame = nullptr;
+    juce::uint64 numDrawn = 0;
+};
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "TripleBuffer.h"
+
+// The last few seconds of input, output and gain reduction, decimated into
+// min/max columns for the editor's waveform display.
+//
+// The audio thread pushes each block's input before processing and its
+// output after, and the GainReductionFifo hands over its points as it
+// completes them. Each of the three fills the columns at its own pace, and a
+// column is finished once all three have passed it. Every few finished
+// columns the newest numColumns are copied, oldest first, into a frame and
+// published through a TripleBuffer, so the editor reads whole frames without
+// locks and the audio thread never waits for it.
+//
+// Nothing is recorded unless a display has switched the history on with
+// setActive(), so instances whose visualiser is closed pay nothing for it.
+class WaveformHistory
+{
+public:
+    static constexpr int numColumns = 512;
+    static constexpr double historySeconds = 4.0;
+
+    struct Column
+    {
+        float inputMin = 0.0f, inputMax = 0.0f;
+        float outputMin = 0.0f, outputMax = 0.0f;
+        float minGain = 1.0f; // deepest reduction in the column
+    };
+
+    struct Frame
+    {
+        std::array<Column, numColumns> columns; // newest last
+        juce::uint64 numFinished = 0;           // since prepare()
+        double secondsPerColumn = 0.0;
+    };
+
+    // Not while the audio thread is pushing. 'samplesPerGainPoint' is the
+    // span of a GainReductionFifo point at the base rate; columns are a whole
+    // number of them.
+    void prepare(double sampleRate, int samplesPerGainPoint)
+    {
+        auto samplesPerPoint = juce::jmax(1, samplesPerGainPoint);
+        pointsPerColumn = juce::jmax(1, juce::roundToInt(sampleRate * historySeconds / numColumns / samplesPerPoint));
+        samplesPerColumn = pointsPerColumn * samplesPerPoint;
+        secondsPerColumn = samplesPerColumn / sampleRate;
+
+        restart();
+        recording = false;
+    }
+
+    // Message thread, while a display is showing.
+    void setActive(bool shouldBeActive) noexcept
+    {
+        active.store(shouldBeActive, std::memory_order_relaxed);
+    }
+
+    // Audio thread only, at the start of each block. Returns whether this
+    // block should be pushed. Switching on starts the history afresh, so the
+    // three cursors start together.
+    bool beginBlock() noexcept
+    {
+        auto wasRecording = recording;
+        recording = active.load(std::memory_order_relaxed);
+
+        if (recording && ! wasRecording)
+            restart();
+
+        return recording;
+    }
+
+    // Audio thread only, in blocks beginBlock() returned true for.
+    template <typename SampleType>
+    void pushInput(const SampleType* const* channels, int numChannels, int numSamples) noexcept
+    {
+        push(input, &Column::inputMin, &Column::inputMax, channels, numChannels, numSamples);
+    }
+
+    // Audio thread only. Publishes a frame once enough columns are finished.
+    template <typename SampleType>
+    void pushOutput(const SampleType* const* channels, int numChannels, int numSamples) noexcept
+    {
+        push(output, &Column::outputMin, &Column::outputMax, channels, numChannels, numSamples);
+        publishIfDue();
+    }
+
+    // Audio thread only, from the GainReductionFifo: the smallest gain over
+    // one of its points.
+    void addGainPoint(float minGain) noexcept
+    {
+        if (! recording)
+            return;
+
+        auto& column = ring[(size_t)(gain.column & ringMask)];
+        column.minGain = gain.filled == 0 ? minGain : juce::jmin(column.minGain, minGain);
+
+        if (++gain.filled == pointsPerColumn)
+            gain = { gain.column + 1, 0 };
+    }
+
+    // Message thread only, one reader. Returns the newest frame if one was
+    // published since the last call, otherwise nullptr. The frame stays
+    // valid until the next call that returns one.
+    const Frame* pull() noexcept
+    {
+        return frames.update() ? &frames.getReadFrame() : nullptr;
+    }
+
+private:
+    // Columns are kept for twice the frame's length, so the columns being
+    // filled ahead of the finished ones never overwrite any a frame shows.
+    static constexpr int ringSize = numColumns * 2;
+    static constexpr juce::uint64 ringMask = ringSize - 1;
+    static constexpr int publishInterval = 4; // about 30 ms
+
+    struct Cursor
+    {
+        juce::uint64 column = 0;
+        int filled = 0; // samples, or gain points
+    };
+
+    void restart() noexcept
+    {
+        ring.fill({});
+        input = {};
+        output = {};
+        gain = {};
+        numPublished = 0;
+    }
+
+    template <typename SampleType>
+    void push(Cursor& cursor, float Column::*minField, float Column::*maxField,
+              const SampleType* const* channels, int numChannels, int numSamples) noexcept
+    {
+        for (int i = 0; i < numSamples;)
+        {
+            auto run = juce::jmin(numSamples - i, samplesPerColumn - cursor.filled);
+            auto& column = ring[(size_t)(cursor.column & ringMask)];
+            auto low = cursor.filled == 0 ? 0.0f : column.*minField;
+            auto high = cursor.filled == 0 ? 0.0f : column.*maxField;
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                for (int j = i; j < i + run; ++j)
+                {
+                    low = juce::jmin(low, (float)channels[ch][j]);
+                    high = juce::jmax(high, (float)channels[ch][j]);
+                }
+            }
+
+            column.*minField = low;
+            column.*maxField = high;
+
+            i += run;
+            cursor.filled += run;
+
+            if (cursor.filled == samplesPerColumn)
+                cursor = { cursor.column + 1, 0 };
+        }
+    }
+
+    void publishIfDue() noexcept
+    {
+        // Paths that compute no gain still feed the FIFO, but should the
+        // gain points stop, the columns they left behind show no reduction
+        // rather than holding the display up.
+        if (input.column > gain.column + (juce::uint64)numColumns / 4)
+        {
+            for (auto c = gain.column + (gain.filled > 0 ? 1 : 0); c < input.column; ++c)
+                ring[(size_t)(c & ringMask)].minGain = 1.0f;
+
+            gain = { input.column, 0 };
+        }
+
+        auto numFinished = juce::jmin(input.column, output.column, gain.column);
+
+        if (numFinished < numPublished + publishInterval)
+            return;
+
+        auto& frame = frames.getWriteFrame();
+        auto numShown = (int)juce::jmin(numFinished, (juce::uint64)numColumns);
+        auto first = numFinished - (juce::uint64)numShown;
+
+        std::fill(frame.columns.begin(), frame.columns.end() - numShown, Column());
+
+        for (int i = 0; i < numShown; ++i)
+            frame.columns[(size_t)(numColumns - numShown + i)] = ring[(size_t)((first + (juce::uint64)i) & ringMask)];
+
+        frame.numFinished = numFinished;
+        frame.secondsPerColumn = secondsPerColumn;
+        frames.publish();
+        numPublished = numFinished;
+    }
+
+    std::array<Column, ringSize> ring;
+    Cursor input, output, gain;
+    juce::uint64 numPublished = 0;
+
+    int pointsPerColumn = 1;
+    int samplesPerColumn = 32;
+    double secondsPerColumn = 0.0;
+
+    TripleBuffer<Frame> frames;
+    std::atomic<bool> active{ false };
+    bool recording = false; // audio thread's copy of 'active' for this block
+};
@@ -0,0 +1,239 @@
+// Allocator and mutex hooks for the real-time audit. They replace malloc and
+// friends, operator new/delete and pthread_mutex_lock/trylock for the whole
+// executable, forward to glibc, and report every call made while
+// RealtimeAudit marks the thread. JUCE's CriticalSection, std::mutex and the
+// default operator new all end up here. Linux and glibc only, like the
+// tool's exporter.
+#include "Hooks.h"
+#include "../../../Source/RealtimeAudit.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#if ! ONECOMP_RT_AUDIT
+ #error "The audit hooks need ONECOMP_RT_AUDIT=1, or processBlock() never marks its thread"
+#endif
+
+extern "C"
+{
+    void* __libc_malloc(size_t);
+    void* __libc_calloc(size_t, size_t);
+    void* __libc_realloc(void*, size_t);
+    void* __libc_memalign(size_t, size_t);
+    void __libc_free(void*);
+}
+
+namespace
+{
+    constexpr int maxRecorded = 32;
+
+    AuditHooks::Violation recorded[maxRecorded];
+    std::atomic<int> numViolations{ 0 };
+    bool abortOnViolation = false;
+
+    // glibc exports its own mutex functions only under compat versions, so
+    // they are looked up on first use. dlsym() locks through ld.so's
+    // internal functions, never these hooks.
+    using MutexFunction = int (*)(pthread_mutex_t*);
+    std::atomic<MutexFunction> realLock{ nullptr }, realTryLock{ nullptr };
+
+    MutexFunction resolve(std::atomic<MutexFunction>& function, const char* name) noexcept
+    {
+        auto f = function.load(std::memory_order_acquire);
+
+        if (f == nullptr)
+        {
+            f = (MutexFunction)dlsym(RTLD_NEXT, name);
+            function.store(f, std::memory_order_release);
+        }
+
+        return f;
+    }
+
+    void writeError(const char* text) noexcept
+    {
+        auto ignored = write(STDERR_FILENO, text, std::strlen(text));
+        (void)ignored;
+    }
+
+    // Allocation-free apart from backtrace(), which install() has warmed up.
+    void record(const char* call, size_t size) noexcept
+    {
+        RealtimeAudit::ScopedSuspend suspend;
+
+        if (abortOnViolation)
+        {
+            void* frames[AuditHooks::maxFrames];
+            auto numFrames = backtrace(frames, AuditHooks::maxFrames);
+
+            writeError("Real-time violation in processBlock: ");
+            writeError(call);
+            writeError("\n");
+            backtrace_symbols_fd(frames, numFrames, STDERR_FILENO);
+            std::abort();
+        }
+
+        auto index = numViolations.fetch_add(1);
+
+        if (index < maxRecorded)
+        {
+            auto& violation = recorded[index];
+            violation.call = call;
+            violation.size = size;
+            violation.numFrames = backtrace(violation.frames, AuditHooks::maxFrames);
+        }
+    }
+
+    inline void check(const char* call, size_t size = 0) noexcept
+    {
+        if (RealtimeAudit::isAudioThread())
+            record(call, size);
+    }
+}
+
+namespace AuditHooks
+{
+    void install(bool shouldAbort)
+    {
+        abortOnViolation = shouldAbort;
+
+        // The first backtrace() loads libgcc_s, which allocates.
+        void* frames[1];
+        backtrace(frames, 1);
+
+        resolve(realLock, "pthread_mutex_lock");
+        resolve(realTryLock, "pthread_mutex_trylock");
+    }
+
+    int getNumViolations() noexcept
+    {
+        return numViolations.load();
+    }
+
+    int getRecorded(const Violation*& first) noexcept
+    {
+        first = recorded;
+        return std::min(numViolations.load(), maxRecorded);
+    }
+
+    void reset() noexcept
+    {
+        numViolations.store(0);
+    }
+}
+
+extern "C"
+{
+    void* malloc(size_t size) noexcept
+    {
+        check("malloc", size);
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size) noexcept
+    {
+        check("calloc", count * size);
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* pointer, size_t size) noexcept
+    {
+        check("realloc", size);
+        return __libc_realloc(pointer, size);
+    }
+
+    void free(void* pointer) noexcept
+    {
+        if (pointer != nullptr)
+            check("free");
+
+        __libc_free(pointer);
+    }
+
+    void* memalign(size_t alignment, size_t size) noexcept
+    {
+        check("memalign", size);
+        return __libc_memalign(alignment, size);
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size) noexcept
+    {
+        check("aligned_alloc", size);
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void** result, size_t alignment, size_t size) noexcept
+    {
+        check("posix_memalign", size);
+        *result = __libc_memalign(alignment, size);
+        return *result != nullptr ? 0 : ENOMEM;
+    }
+
+    int pthread_mutex_lock(pthread_mutex_t* mutex) noexcept
+    {
+        check("pthread_mutex_lock");
+        return resolve(realLock, "pthread_mutex_lock")(mutex);
+    }
+
+    int pthread_mutex_trylock(pthread_mutex_t* mutex) noexcept
+    {
+        check("pthread_mutex_trylock");
+        return resolve(realTryLock, "pthread_mutex_trylock")(mutex);
+    }
+}
+
+// These go straight to glibc, so one new is one report rather than two.
+void* operator new(std::size_t size)
+{
+    check("operator new", size);
+
+    if (auto* pointer = __libc_malloc(size == 0 ? 1 : size))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    check("operator new[]", size);
+
+    if (auto* pointer = __libc_malloc(size == 0 ? 1 : size))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept
+{
+    if (pointer != nullptr)
+        check("operator delete");
+
+    __libc_free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    if (pointer != nullptr)
+        check("operator delete[]");
+
+    __libc_free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+    operator delete[](pointer);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+
+// What the hooks in Hooks.cpp record. A violation is any allocator or mutex
+// call made while RealtimeAudit marks the thread, i.e. inside processBlock().
+namespace AuditHooks
+{
+    constexpr int maxFrames = 24;
+
+    struct Violation
+    {
+        const char* call = nullptr;
+        size_t size = 0;
+        void* frames[maxFrames] = {};
+        int numFrames = 0;
+    };
+
+    // Call first thing in main(). With abortOnViolation the first violation
+    // prints its stack to stderr and aborts, for a core dump or a debugger.
+    void install(bool abortOnViolation);
+
+    // Violations since the last reset(). Only the first few are recorded
+    // with their stacks; getRecorded() returns how many.
+    int getNumViolations() noexcept;
+    int getRecorded(const Violation*& first) noexcept;
+    void reset() noexcept;
+}
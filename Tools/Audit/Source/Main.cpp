@@ -0,0 +1,335 @@
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+#include "Hooks.h"
+
+#include <execinfo.h>
+#include <iostream>
+#include <thread>
+
+namespace
+{
+    struct AuditSettings
+    {
+        double seconds = 10.0;
+        double sampleRate = 48000.0;
+        int maxBlockSize = 512;
+        juce::int64 seed = 1;
+        bool abortOnViolation = false;
+    };
+
+    struct Layout
+    {
+        const char* name;
+        juce::AudioChannelSet main;
+        juce::AudioChannelSet sidechain;
+    };
+
+    void printUsage()
+    {
+        std::cout << "Usage: oneCompAudit [options]\n"
+                     "\n"
+                     "Runs the processor under hooks that report any allocation, free or mutex\n"
+                     "lock made inside processBlock(), and exits with 1 if there was one.\n"
+                     "\n"
+                     "  --seconds <n>          Audio processed per scenario (default 10)\n"
+                     "  --rate <n>             Sample rate (default 48000)\n"
+                     "  --block-size <n>       Largest block; blocks vary from 1 up to it (default 512)\n"
+                     "  --seed <n>             Seed for the automation and block sizes (default 1)\n"
+                     "  --abort                Abort with a stack trace at the first violation\n"
+                  << std::endl;
+    }
+
+    // Prints and clears what the hooks recorded. Only called while nothing
+    // is processing, so the records are not being written.
+    bool report(const juce::String& scenario)
+    {
+        auto numViolations = AuditHooks::getNumViolations();
+        const AuditHooks::Violation* recorded = nullptr;
+        auto numRecorded = AuditHooks::getRecorded(recorded);
+
+        std::cout << scenario.paddedRight(' ', 32)
+                  << (numViolations == 0 ? juce::String("ok") : juce::String(numViolations) + " violations") << std::endl;
+
+        for (int i = 0; i < numRecorded; ++i)
+        {
+            auto& violation = recorded[i];
+            std::cout << "  " << violation.call;
+
+            if (violation.size > 0)
+                std::cout << " (" << violation.size << " bytes)";
+
+            std::cout << std::endl;
+
+            // The first two frames are the hook's own.
+            if (auto** symbols = backtrace_symbols(violation.frames, violation.numFrames))
+            {
+                for (int frame = 2; frame < violation.numFrames; ++frame)
+                    std::cout << "      " << symbols[frame] << std::endl;
+
+                free(symbols);
+            }
+        }
+
+        AuditHooks::reset();
+        return numViolations == 0;
+    }
+
+    bool applyLayout(OneCompAudioProcessor& processor, const Layout& layout, const AuditSettings& settings, bool doublePrecision)
+    {
+        processor.releaseResources();
+
+        auto buses = processor.getBusesLayout();
+        buses.getChannelSet(true, 0) = layout.main;
+        buses.getChannelSet(false, 0) = layout.main;
+
+        if (buses.inputBuses.size() > 1)
+            buses.getChannelSet(true, 1) = layout.sidechain;
+
+        if (! processor.setBusesLayout(buses))
+            return false;
+
+        processor.setProcessingPrecision(doublePrecision ? juce::AudioProcessor::doublePrecision
+                                                         : juce::AudioProcessor::singlePrecision);
+        processor.setRateAndBufferSizeDetails(settings.sampleRate, settings.maxBlockSize);
+        processor.prepareToPlay(settings.sampleRate, settings.maxBlockSize);
+        return true;
+    }
+
+    // Sets a few random parameters to random values, now and then, on the
+    // audio thread as hosts do. Half the time they are set before the block,
+    // outside processBlock(), where the parameter listeners they run are the
+    // wrapper's business; otherwise they are queued at random offsets inside
+    // it with addParameterChange(), so that the block is split.
+    void automate(OneCompAudioProcessor& processor, int numSamples, juce::Random& random)
+    {
+        if (random.nextInt(4) != 0)
+            return;
+
+        auto& params = processor.getParameters();
+        auto sampleAccurate = random.nextBool();
+
+        for (int i = random.nextInt(3); i >= 0; --i)
+        {
+            auto index = random.nextInt(params.size());
+
+            if (sampleAccurate)
+                processor.addParameterChange(random.nextInt(numSamples), index, random.nextFloat());
+            else
+                params[index]->setValueNotifyingHost(random.nextFloat());
+        }
+    }
+
+    // Noise, a sine or silence, switching every half second or so, so the
+    // silence and bypass fast paths are entered and left as well.
+    template <typename SampleType>
+    void fillBlock(juce::AudioBuffer<SampleType>& buffer, int numSamples, juce::Random& random,
+                   int& segmentLeft, int& segmentType, double& phase, double sampleRate)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            if (--segmentLeft <= 0)
+            {
+                segmentLeft = (int)(sampleRate * (0.1 + random.nextDouble()));
+                segmentType = random.nextInt(3);
+            }
+
+            auto sample = segmentType == 0 ? (SampleType)(random.nextFloat() * 2.0f - 1.0f)
+                        : segmentType == 1 ? (SampleType)(0.7 * std::sin(phase))
+                                           : SampleType();
+            phase += 2.0 * juce::MathConstants<double>::pi * 220.0 / sampleRate;
+
+            for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                buffer.setSample(ch, i, sample);
+        }
+    }
+
+    // Processes 'seconds' of audio in blocks of varying size, automating
+    // between and within blocks. The buffer is sized as a host would size it: the
+    // larger of the input channels, sidechain included, and the outputs.
+    template <typename SampleType>
+    void process(OneCompAudioProcessor& processor, const AuditSettings& settings, double seconds, juce::Random& random)
+    {
+        auto numChannels = juce::jmax(processor.getTotalNumInputChannels(), processor.getTotalNumOutputChannels());
+        juce::AudioBuffer<SampleType> storage(numChannels, settings.maxBlockSize);
+        juce::MidiBuffer midi;
+
+        auto segmentLeft = 0, segmentType = 0;
+        auto phase = 0.0;
+
+        for (auto remaining = (juce::int64)(seconds * settings.sampleRate); remaining > 0;)
+        {
+            auto numSamples = random.nextInt(4) == 0 ? settings.maxBlockSize : 1 + random.nextInt(settings.maxBlockSize);
+            numSamples = (int)juce::jmin((juce::int64)numSamples, remaining);
+            remaining -= numSamples;
+
+            automate(processor, numSamples, random);
+            fillBlock(storage, numSamples, random, segmentLeft, segmentType, phase, settings.sampleRate);
+
+            juce::AudioBuffer<SampleType> block(storage.getArrayOfWritePointers(), numChannels, numSamples);
+            processor.processBlock(block, midi);
+        }
+    }
+
+    template <typename SampleType>
+    bool runAutomation(const AuditSettings& settings, const juce::String& precision)
+    {
+        OneCompAudioProcessor processor;
+        juce::Random random(settings.seed);
+        Layout layout{ "stereo", juce::AudioChannelSet::stereo(), juce::AudioChannelSet::stereo() };
+
+        if (! applyLayout(processor, layout, settings, std::is_same<SampleType, double>::value))
+            return false;
+
+        process<SampleType>(processor, settings, settings.seconds, random);
+        return report("automation " + precision);
+    }
+
+    // Each layout is prepared outside the audited scope, as a host does
+    // between suspending and resuming the plugin, then processed.
+    template <typename SampleType>
+    bool runLayouts(const AuditSettings& settings, const juce::String& precision)
+    {
+        const Layout layouts[] = {
+            { "mono", juce::AudioChannelSet::mono(), juce::AudioChannelSet::disabled() },
+            { "mono, mono key", juce::AudioChannelSet::mono(), juce::AudioChannelSet::mono() },
+            { "stereo", juce::AudioChannelSet::stereo(), juce::AudioChannelSet::disabled() },
+            { "stereo, stereo key", juce::AudioChannelSet::stereo(), juce::AudioChannelSet::stereo() },
+            { "5.1", juce::AudioChannelSet::create5point1(), juce::AudioChannelSet::disabled() },
+            { "5.1, stereo key", juce::AudioChannelSet::create5point1(), juce::AudioChannelSet::stereo() },
+            { "7.1.4", juce::AudioChannelSet::create7point1point4(), juce::AudioChannelSet::disabled() },
+            { "7.1.4, mono key", juce::AudioChannelSet::create7point1point4(), juce::AudioChannelSet::mono() },
+        };
+
+        OneCompAudioProcessor processor;
+        juce::Random random(settings.seed);
+        auto ok = true;
+
+        for (auto& layout : layouts)
+        {
+            if (! applyLayout(processor, layout, settings, std::is_same<SampleType, double>::value))
+            {
+                std::cout << "layout " << layout.name << " was refused" << std::endl;
+                ok = false;
+                continue;
+            }
+
+            process<SampleType>(processor, settings, settings.seconds / juce::numElementsInArray(layouts), random);
+            ok = report("layout " + juce::String(layout.name) + " " + precision) && ok;
+        }
+
+        return ok;
+    }
+
+    // Another thread restores saved states, in both formats, and selects
+    // presets while the audio is processed, as a host's message thread does.
+    template <typename SampleType>
+    bool runStateRestores(const AuditSettings& settings, const juce::String& precision)
+    {
+        OneCompAudioProcessor processor;
+        juce::Random random(settings.seed);
+        Layout layout{ "stereo", juce::AudioChannelSet::stereo(), juce::AudioChannelSet::stereo() };
+
+        if (! applyLayout(processor, layout, settings, std::is_same<SampleType, double>::value))
+            return false;
+
+        // A few saved states to cycle through, from presets and random settings.
+        juce::Array<juce::MemoryBlock> states;
+        OneCompAudioProcessor source;
+        juce::MemoryBlock state;
+
+        for (int i = 0; i < source.getNumPrograms(); ++i)
+        {
+            source.setCurrentProgram(i);
+            source.getStateInformation(state);
+            states.add(state);
+        }
+
+        for (int i = 0; i < 4; ++i)
+        {
+            for (auto* param : source.getParameters())
+                param->setValueNotifyingHost(random.nextFloat());
+
+            source.getStateInformation(state);
+            states.add(state);
+
+            // The XML form, as an older version saved it.
+            juce::AudioProcessor::copyXmlToBinary(*source.parameters.copyState().createXml(), state);
+            states.add(state);
+        }
+
+        std::atomic<bool> done{ false };
+
+        std::thread restorer([&]
+        {
+            juce::Random restoreRandom(settings.seed + 1);
+
+            while (! done.load())
+            {
+                if (restoreRandom.nextInt(3) == 0)
+                {
+                    processor.setCurrentProgram(restoreRandom.nextInt(processor.getNumPrograms()));
+                }
+                else
+                {
+                    auto& state = states.getReference(restoreRandom.nextInt(states.size()));
+                    processor.setStateInformation(state.getData(), (int)state.getSize());
+                }
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(restoreRandom.nextInt(5)));
+            }
+        });
+
+        process<SampleType>(processor, settings, settings.seconds, random);
+
+        done.store(true);
+        restorer.join();
+        return report("state restores " + precision);
+    }
+
+    template <typename SampleType>
+    bool runAll(const AuditSettings& settings)
+    {
+        auto precision = std::is_same<SampleType, double>::value ? "(double)" : "(float)";
+        auto automationOk = runAutomation<SampleType>(settings, precision);
+        auto layoutsOk = runLayouts<SampleType>(settings, precision);
+        auto stateOk = runStateRestores<SampleType>(settings, precision);
+        return automationOk && layoutsOk && stateOk;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    AuditSettings settings;
+    juce::StringArray args(argv + 1, argc - 1);
+
+    for (int i = 0; i < args.size(); ++i)
+    {
+        auto arg = args[i];
+        auto hasValue = i + 1 < args.size();
+
+        if (arg == "--seconds" && hasValue)
+            settings.seconds = juce::jmax(0.1, args[++i].getDoubleValue());
+        else if (arg == "--rate" && hasValue)
+            settings.sampleRate = juce::jlimit(8000.0, 768000.0, args[++i].getDoubleValue());
+        else if (arg == "--block-size" && hasValue)
+            settings.maxBlockSize = juce::jlimit(1, 1 << 16, args[++i].getIntValue());
+        else if (arg == "--seed" && hasValue)
+            settings.seed = args[++i].getLargeIntValue();
+        else if (arg == "--abort")
+            settings.abortOnViolation = true;
+        else
+        {
+            printUsage();
+            return arg == "-h" || arg == "--help" ? 0 : 1;
+        }
+    }
+
+    AuditHooks::install(settings.abortOnViolation);
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    auto floatOk = runAll<float>(settings);
+    auto doubleOk = runAll<double>(settings);
+
+    std::cout << (floatOk && doubleOk ? "No real-time violations" : "Real-time violations found") << std::endl;
+    return floatOk && doubleOk ? 0 : 1;
+}
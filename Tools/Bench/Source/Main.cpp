@@ -0,0 +1,1216 @@
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+#include "../../../Source/CompressorBank.h"
+
+#include <chrono>
+#include <iostream>
+#include <map>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct BenchSettings
+    {
+        juce::Array<double> sampleRates{ 44100.0, 48000.0, 96000.0, 192000.0 };
+        juce::Array<int> blockSizes{ 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+        juce::Array<int> channelCounts{ 1, 2 };
+        juce::StringArray signals{ "silence", "sine", "pink", "drums" };
+        juce::StringArray precisions{ "float" };
+        double seconds = 5.0;
+        juce::File jsonFile;
+        juce::File compareFile;
+        juce::String label;
+        juce::StringPairArray parameterValues;
+        juce::Array<int> bankSizes;
+        bool verify = false;
+    };
+
+    struct Result
+    {
+        juce::String signal;
+        double sampleRate = 0;
+        int blockSize = 0, numChannels = 0;
+        juce::String precision;
+        double nsPerSample = 0, realtimeFactor = 0;
+        double p50Us = 0, p99Us = 0, maxUs = 0;
+
+        // Float results keep the key they had before double precision was
+        // benchmarked, so older JSON runs still compare.
+        static juce::String makeKey(const juce::String& signal, int sampleRate, int blockSize, int numChannels,
+                                    const juce::String& precision)
+        {
+            return signal + "/" + juce::String(sampleRate) + "/" + juce::String(blockSize) + "/" + juce::String(numChannels)
+                   + (precision == "double" ? "/double" : "");
+        }
+
+        juce::String getKey() const
+        {
+            return makeKey(signal, (int)sampleRate, blockSize, numChannels, precision);
+        }
+    };
+
+    //==============================================================================
+    // Test signals are deterministic so that runs on different commits see
+    // identical input.
+    void generateSignal(const juce::String& name, juce::AudioBuffer<float>& buffer, double sampleRate)
+    {
+        buffer.clear();
+        juce::Random random(0x0c0ffee);
+        auto numSamples = buffer.getNumSamples();
+        auto* data = buffer.getWritePointer(0);
+
+        if (name == "sine")
+        {
+            auto delta = juce::MathConstants<double>::twoPi * 997.0 / sampleRate;
+
+            for (int i = 0; i < numSamples; ++i)
+                data[i] = 0.5f * (float)std::sin(delta * i);
+        }
+        else if (name == "pink")
+        {
+            // Paul Kellet's economy pink filter.
+            float b0 = 0, b1 = 0, b2 = 0;
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto white = random.nextFloat() * 2.0f - 1.0f;
+                b0 = 0.99765f * b0 + white * 0.0990460f;
+                b1 = 0.96300f * b1 + white * 0.2965164f;
+                b2 = 0.57000f * b2 + white * 1.0526913f;
+                data[i] = 0.15f * (b0 + b1 + b2 + white * 0.1848f);
+            }
+        }
+        else if (name == "drums")
+        {
+            // 120 bpm: kick on the beat, snare on the off-beat, hats on eighths.
+            auto beat = (int)(sampleRate * 0.5);
+            auto eighth = beat / 2;
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto tBeat = (double)(i % beat) / sampleRate;
+                auto tSnare = (double)((i + beat / 2) % beat) / sampleRate;
+                auto tHat = (double)(i % eighth) / sampleRate;
+
+                auto kickPhase = juce::MathConstants<double>::twoPi * (50.0 * tBeat + 12.0 * (1.0 - std::exp(-tBeat * 40.0)));
+                auto kick = std::sin(kickPhase) * std::exp(-tBeat * 12.0);
+                auto noise = random.nextFloat() * 2.0f - 1.0f;
+                auto snare = ((i / beat) % 2 == 1 ? 0.6 : 0.0) * noise * std::exp(-tSnare * 25.0);
+                auto hat = 0.2 * noise * std::exp(-tHat * 120.0);
+
+                data[i] = (float)(0.8 * kick + snare + hat);
+            }
+        }
+
+        for (int ch = 1; ch < buffer.getNumChannels(); ++ch)
+            buffer.copyFrom(ch, 0, buffer, 0, 0, numSamples);
+    }
+
+    bool prepareProcessor(OneCompAudioProcessor& processor, const BenchSettings& settings,
+                          int numChannels, double sampleRate, int blockSize, bool doublePrecision = false)
+    {
+        for (auto& id : settings.parameterValues.getAllKeys())
+            if (auto* param = processor.parameters.getParameter(id))
+                param->setValueNotifyingHost(param->convertTo0to1(settings.parameterValues[id].getFloatValue()));
+
+        auto channelSet = juce::AudioChannelSet::canonicalChannelSet(numChannels);
+
+        auto layout = processor.getBusesLayout();
+        layout.getChannelSet(true, 0) = channelSet;
+        layout.getChannelSet(false, 0) = channelSet;
+
+        if (layout.inputBuses.size() > 1)
+            layout.getChannelSet(true, 1) = juce::AudioChannelSet::disabled();
+
+        if (! processor.setBusesLayout(layout))
+            return false;
+
+        processor.setProcessingPrecision(doublePrecision ? juce::AudioProcessor::doublePrecision
+                                                         : juce::AudioProcessor::singlePrecision);
+        processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+        return true;
+    }
+
+    double percentile(std::vector<double>& sorted, double p)
+    {
+        if (sorted.empty())
+            return 0.0;
+
+        auto index = (size_t)juce::jlimit(0.0, (double)(sorted.size() - 1), std::ceil(p * (double)sorted.size()) - 1.0);
+        return sorted[index];
+    }
+
+    template <typename SampleType>
+    Result runOne(const BenchSettings& settings, const juce::String& signal, const juce::AudioBuffer<float>& source,
+                  double sampleRate, int blockSize, int numChannels)
+    {
+        constexpr auto isDouble = std::is_same<SampleType, double>::value;
+        Result result{ signal, sampleRate, blockSize, numChannels, isDouble ? "double" : "float" };
+
+        OneCompAudioProcessor processor;
+
+        if (! prepareProcessor(processor, settings, numChannels, sampleRate, blockSize, isDouble))
+            return result;
+
+        // The source is converted once, so the timed loop only copies.
+        juce::AudioBuffer<SampleType> converted;
+        converted.makeCopyOf(source);
+
+        juce::AudioBuffer<SampleType> block(numChannels, blockSize);
+        juce::MidiBuffer midi;
+
+        auto sourceLength = source.getNumSamples() - source.getNumSamples() % blockSize;
+        auto numBlocks = juce::jmax(1, (int)(settings.seconds * sampleRate) / blockSize);
+        auto numWarmupBlocks = juce::jmax(1, numBlocks / 10);
+
+        std::vector<double> blockTimes;
+        blockTimes.reserve((size_t)numBlocks);
+        double totalNs = 0.0;
+
+        for (int i = -numWarmupBlocks, position = 0; i < numBlocks; ++i)
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+                block.copyFrom(ch, 0, converted, ch, position, blockSize);
+
+            position = (position + blockSize) % sourceLength;
+
+            auto start = Clock::now();
+            processor.processBlock(block, midi);
+            auto ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+            if (i >= 0)
+            {
+                blockTimes.push_back(ns);
+                totalNs += ns;
+            }
+        }
+
+        std::sort(blockTimes.begin(), blockTimes.end());
+
+        auto numSamples = (double)numBlocks * blockSize;
+        result.nsPerSample = totalNs / (numSamples * numChannels);
+        result.realtimeFactor = totalNs > 0.0 ? (numSamples / sampleRate) * 1.0e9 / totalNs : 0.0;
+        result.p50Us = percentile(blockTimes, 0.50) * 1.0e-3;
+        result.p99Us = percentile(blockTimes, 0.99) * 1.0e-3;
+        result.maxUs = blockTimes.back() * 1.0e-3;
+        return result;
+    }
+
+    //==============================================================================
+    struct KernelConfig
+    {
+        LevelDetectorBase::Mode detector;
+        CompressorKernelBase::LinkMode link;
+        const char* name;
+        bool automatic = false;
+    };
+
+    const KernelConfig kernelConfigs[] = {
+        { LevelDetectorBase::Mode::peak, CompressorKernelBase::LinkMode::unlinked, "peak, unlinked" },
+        { LevelDetectorBase::Mode::rms, CompressorKernelBase::LinkMode::linkedMax, "rms, linked max" },
+        { LevelDetectorBase::Mode::truePeak, CompressorKernelBase::LinkMode::midSide, "true peak, mid/side" },
+        { LevelDetectorBase::Mode::peak, CompressorKernelBase::LinkMode::linkedAverage, "peak, linked average" },
+        { LevelDetectorBase::Mode::peak, CompressorKernelBase::LinkMode::unlinked, "peak, unlinked, auto", true },
+        { LevelDetectorBase::Mode::rms, CompressorKernelBase::LinkMode::linkedMax, "rms, linked max, auto", true }
+    };
+
+    // Heavy compression with lookahead and a knee, so every stage matters.
+    CompressorKernelBase::Parameters getVerifyParameters(const KernelConfig& config)
+    {
+        CompressorKernelBase::Parameters params;
+        params.inputGainDb = 6.0f;
+        params.makeupGainDb = 3.5f;
+        params.thresholdDb = -24.0f;
+        params.ratio = 6.0f;
+        params.attackMs = 0.5f;
+        params.releaseMs = 80.0f;
+        params.lookaheadMs = 5.0f;
+        params.kneeDb = 6.0f;
+        params.detector = config.detector;
+        params.link = config.link;
+        params.autoAttack = config.automatic;
+        params.autoRelease = config.automatic;
+        return params;
+    }
+
+    // Runs the vectorised kernel and the scalar reference over the same input
+    // and checks that audio matches exactly and the meter sums closely.
+    template <typename SampleType>
+    bool verifyKernel(const BenchSettings& settings)
+    {
+        auto ok = true;
+        auto precision = std::is_same<SampleType, double>::value ? "double" : "float";
+
+        for (auto& signal : settings.signals)
+        {
+            for (auto& config : kernelConfigs)
+            {
+                juce::AudioBuffer<float> input(2, 48000);
+                generateSignal(signal, input, 48000.0);
+
+                juce::AudioBuffer<SampleType> vectorised, reference;
+                vectorised.makeCopyOf(input);
+                reference.makeCopyOf(input);
+
+                CompressorKernel<SampleType> a, b;
+                auto params = getVerifyParameters(config);
+
+                for (auto* kernel : { &a, &b })
+                {
+                    kernel->prepare(48000.0, 2);
+                    kernel->setParameters(params);
+                }
+
+                // Switch the gains halfway through so that the ramps are exercised.
+                auto automated = params;
+                automated.inputGainDb = -3.0f;
+                automated.makeupGainDb = 9.0f;
+
+                auto worstLevelError = 0.0;
+                auto samplesDiffering = 0;
+
+                for (int start = 0; start < vectorised.getNumSamples(); start += 333)
+                {
+                    auto n = juce::jmin(333, vectorised.getNumSamples() - start);
+
+                    if (start >= 24000 && start < 24000 + 333)
+                    {
+                        a.setParameters(automated);
+                        b.setParameters(automated);
+                    }
+                    SampleType* va[] = { vectorised.getWritePointer(0, start), vectorised.getWritePointer(1, start) };
+                    SampleType* ra[] = { reference.getWritePointer(0, start), reference.getWritePointer(1, start) };
+
+                    auto lv = a.process(va, 2, n);
+                    auto lr = b.processScalar(ra, 2, n);
+
+                    for (auto [x, y] : { std::make_pair(lv.input, lr.input),
+                                         std::make_pair(lv.compressed, lr.compressed),
+                                         std::make_pair(lv.output, lr.output) })
+                        worstLevelError = juce::jmax(worstLevelError, (double)(std::abs(x - y) / juce::jmax((SampleType)1.0e-6, std::abs(y))));
+                }
+
+                for (int ch = 0; ch < 2; ++ch)
+                    for (int i = 0; i < vectorised.getNumSamples(); ++i)
+                        samplesDiffering += vectorised.getSample(ch, i) != reference.getSample(ch, i) ? 1 : 0;
+
+                auto passed = samplesDiffering == 0 && worstLevelError < 1.0e-4;
+                ok = ok && passed;
+
+                std::cout << "verify " << precision << " " << signal << " (" << config.name << "): " << samplesDiffering
+                          << " samples differ, level error " << worstLevelError << (passed ? "  ok" : "  FAILED") << std::endl;
+            }
+        }
+
+        return ok;
+    }
+
+    // The hard-knee curve built on FastMath against std::pow, over 120 dB of
+    // envelope and the full ratio range.
+    template <typename SampleType>
+    bool verifyGainComputer()
+    {
+        auto worstDb = 0.0;
+
+        for (auto ratio : { 1.5f, 2.0f, 4.0f, 10.0f, 20.0f })
+        {
+            GainComputer<SampleType> curve;
+            curve.setParameters(-30.0f, ratio, 0.0f);
+            auto threshold = std::pow(10.0, -30.0 / 20.0);
+
+            for (auto db = -100.0; db <= 20.0; db += 0.01)
+            {
+                auto envelope = std::pow(10.0, db / 20.0);
+                auto exact = envelope < threshold ? 1.0 : std::pow(envelope / threshold, 1.0 / ratio - 1.0);
+                auto error = std::abs(20.0 * std::log10((double)curve.getGain((SampleType)envelope) / exact));
+                worstDb = juce::jmax(worstDb, error);
+            }
+        }
+
+        auto passed = worstDb < 0.001;
+        std::cout << "verify " << (std::is_same<SampleType, double>::value ? "double" : "float")
+                  << " gain computer: worst error " << worstDb << " dB" << (passed ? "  ok" : "  FAILED") << std::endl;
+        return passed;
+    }
+
+    template <typename SampleType>
+    bool verifyMultiband(const BenchSettings& settings)
+    {
+        auto ok = true;
+        auto precision = std::is_same<SampleType, double>::value ? "double" : "float";
+
+        // The 44.1 kHz case puts the upper crossovers at the top of their
+        // range, above the 0.45 fs limit they are clamped to.
+        for (auto sampleRate : { 48000.0, 44100.0 })
+        {
+            for (auto& signal : settings.signals)
+            {
+                for (auto automatic : { false, true })
+                {
+                    juce::AudioBuffer<float> input(2, (int)sampleRate);
+                    generateSignal(signal, input, sampleRate);
+
+                    juce::AudioBuffer<SampleType> vectorised, reference;
+                    vectorised.makeCopyOf(input);
+                    reference.makeCopyOf(input);
+
+                    MultibandCompressor<SampleType> a, b;
+                    MultibandCompressorBase::Parameters params;
+                    params.numBands = 4;
+                    params.inputGainDb = 6.0f;
+                    params.bands[0].thresholdDb = -30.0f;
+                    params.bands[2].ratio = 8.0f;
+                    params.bands[3].attackMs = 0.5f;
+                    params.autoAttack = automatic;
+                    params.autoRelease = automatic;
+
+                    if (sampleRate == 44100.0)
+                        params.crossoverHz = { { 12000.0f, 20000.0f, 20000.0f } };
+
+                    for (auto* compressor : { &a, &b })
+                    {
+                        compressor->setParameters(params);
+                        compressor->prepare(sampleRate, 2);
+                    }
+
+                    a.process(vectorised.getArrayOfWritePointers(), 2, vectorised.getNumSamples());
+                    b.processScalar(reference.getArrayOfWritePointers(), 2, reference.getNumSamples());
+
+                    auto worstError = 0.0;
+                    auto finite = true;
+
+                    for (int ch = 0; ch < 2; ++ch)
+                    {
+                        for (int i = 0; i < vectorised.getNumSamples(); ++i)
+                        {
+                            worstError = juce::jmax(worstError, (double)std::abs(vectorised.getSample(ch, i) - reference.getSample(ch, i)));
+                            finite = finite && std::isfinite(vectorised.getSample(ch, i));
+                        }
+                    }
+
+                    auto passed = finite && worstError < 1.0e-5;
+                    ok = ok && passed;
+
+                    std::cout << "verify " << precision << " multiband " << signal << " at " << sampleRate << " Hz" << (automatic ? " (auto)" : "")
+                              << ": max error " << worstError << (finite ? "" : ", not finite") << (passed ? "  ok" : "  FAILED") << std::endl;
+                }
+            }
+        }
+
+        return ok;
+    }
+
+    // The float kernel against the double one on the same input. They share
+    // every formula, so the difference is float rounding, accumulated through
+    // the envelope recursions; it has to stay far below anything audible.
+    bool verifyPrecision(const BenchSettings& settings)
+    {
+        auto ok = true;
+
+        for (auto& signal : settings.signals)
+        {
+            for (auto& config : kernelConfigs)
+            {
+                juce::AudioBuffer<float> single(2, 48000);
+                generateSignal(signal, single, 48000.0);
+
+                juce::AudioBuffer<double> twice;
+                twice.makeCopyOf(single);
+
+                CompressorKernel<float> a;
+                CompressorKernel<double> b;
+                auto params = getVerifyParameters(config);
+
+                a.prepare(48000.0, 2);
+                a.setParameters(params);
+                b.prepare(48000.0, 2);
+                b.setParameters(params);
+
+                for (int start = 0; start < single.getNumSamples(); start += 512)
+                {
+                    auto n = juce::jmin(512, single.getNumSamples() - start);
+                    float* sa[] = { single.getWritePointer(0, start), single.getWritePointer(1, start) };
+                    double* da[] = { twice.getWritePointer(0, start), twice.getWritePointer(1, start) };
+
+                    a.process(sa, 2, n);
+                    b.process(da, 2, n);
+                }
+
+                auto worstError = 0.0, peak = 0.0;
+
+                for (int ch = 0; ch < 2; ++ch)
+                {
+                    for (int i = 0; i < single.getNumSamples(); ++i)
+                    {
+                        worstError = juce::jmax(worstError, std::abs((double)single.getSample(ch, i) - twice.getSample(ch, i)));
+                        peak = juce::jmax(peak, std::abs(twice.getSample(ch, i)));
+                    }
+                }
+
+                // Relative to the output peak, so the bound does not depend
+                // on the signal's level. 80 dB down is a gain error of about
+                // 0.001 dB, the gain computer's own accuracy.
+                auto relativeError = peak > 0.0 ? worstError / peak : worstError;
+                auto passed = relativeError < 1.0e-4;
+                ok = ok && passed;
+
+                std::cout << "verify float vs double " << signal << " (" << config.name << "): max error "
+                          << juce::Decibels::gainToDecibels(relativeError, -300.0) << " dB below peak"
+                          << (passed ? "  ok" : "  FAILED") << std::endl;
+            }
+        }
+
+        return ok;
+    }
+
+    // Bursts with a second of silence between them, through the kernel with
+    // and without the silence fast path. Skipped blocks must be exact zeros
+    // where the reference is below the floor, and the bursts must match.
+    bool verifySilence()
+    {
+        auto ok = true;
+
+        for (auto lookaheadMs : { 0.0f, 5.0f })
+        {
+            juce::AudioBuffer<float> gated(2, 48000 * 3), reference;
+
+            for (int ch = 0; ch < 2; ++ch)
+                for (int i = 0; i < gated.getNumSamples(); ++i)
+                    gated.setSample(ch, i, i < 20000 || i > 100000 ? 0.5f * (float)std::sin(i * 0.02) : 0.0f);
+
+            reference.makeCopyOf(gated);
+
+            CompressorKernel<float> a, b;
+            auto params = getVerifyParameters(kernelConfigs[0]);
+            params.lookaheadMs = lookaheadMs;
+
+            for (auto* kernel : { &a, &b })
+            {
+                kernel->prepare(48000.0, 2);
+                kernel->setParameters(params);
+            }
+
+            auto numSkipped = 0;
+            auto worstError = 0.0f, worstSkipped = 0.0f;
+
+            for (int start = 0; start < gated.getNumSamples(); start += 512)
+            {
+                auto n = juce::jmin(512, gated.getNumSamples() - start);
+                float* ga[] = { gated.getWritePointer(0, start), gated.getWritePointer(1, start) };
+                float* ra[] = { reference.getWritePointer(0, start), reference.getWritePointer(1, start) };
+
+                auto skipped = a.processSilence(ga, 2, n);
+
+                if (! skipped)
+                    a.process(ga, 2, n);
+
+                b.process(ra, 2, n);
+                numSkipped += skipped ? 1 : 0;
+
+                for (int ch = 0; ch < 2; ++ch)
+                {
+                    for (int i = 0; i < n; ++i)
+                    {
+                        worstError = juce::jmax(worstError, std::abs(ga[ch][i] - ra[ch][i]));
+
+                        if (skipped)
+                            worstSkipped = juce::jmax(worstSkipped, std::abs(ra[ch][i]));
+                    }
+                }
+            }
+
+            auto passed = numSkipped > 0 && worstSkipped < SilenceGate::floor && worstError < 1.0e-5f;
+            ok = ok && passed;
+
+            std::cout << "verify silence (lookahead " << lookaheadMs << " ms): " << numSkipped << " blocks skipped, max error "
+                      << worstError << (passed ? "  ok" : "  FAILED") << std::endl;
+        }
+
+        return ok;
+    }
+
+    // Bypassed with lookahead, after the fade the output must be the input
+    // delayed by exactly the reported latency.
+    bool verifyBypass(const BenchSettings& settings)
+    {
+        auto bypassed = settings;
+        bypassed.parameterValues.set("lookahead", "5");
+        bypassed.parameterValues.set("bypass", "1");
+
+        OneCompAudioProcessor processor;
+
+        if (! prepareProcessor(processor, bypassed, 2, 48000.0, 512))
+            return false;
+
+        juce::AudioBuffer<float> input(2, 48000), block(2, 512);
+        generateSignal("drums", input, 48000.0);
+
+        juce::MidiBuffer midi;
+        auto latency = processor.getLatencySamples();
+        auto worstError = 0.0f;
+
+        for (int start = 0; start + 512 <= input.getNumSamples(); start += 512)
+        {
+            for (int ch = 0; ch < 2; ++ch)
+                block.copyFrom(ch, 0, input, ch, start, 512);
+
+            processor.processBlock(block, midi);
+
+            for (int ch = 0; ch < 2; ++ch)
+                for (int i = 0; i < 512; ++i)
+                    if (start + i >= latency)
+                        worstError = juce::jmax(worstError, std::abs(block.getSample(ch, i) - input.getSample(ch, start + i - latency)));
+        }
+
+        auto passed = latency > 0 && worstError == 0.0f;
+        std::cout << "verify bypass: latency " << latency << ", max error " << worstError << (passed ? "  ok" : "  FAILED") << std::endl;
+        return passed;
+    }
+
+    // Renders 'input' offline in blocks of blockSize, with the threshold swept
+    // on a 32-sample grid and the ratio, oversampling and bypass stepped, all
+    // through addParameterChange().
+    juce::AudioBuffer<float> renderAutomated(const BenchSettings& settings, const juce::AudioBuffer<float>& input, int blockSize)
+    {
+        struct Step
+        {
+            int position;
+            const char* id;
+            float value;
+        };
+
+        const Step steps[] = { { 30011, "ratio", 12.0f }, { 45000, "oversampling", 1.0f },
+                               { 70001, "bypass", 1.0f }, { 80013, "bypass", 0.0f } };
+
+        OneCompAudioProcessor processor;
+        processor.setNonRealtime(true);
+
+        juce::AudioBuffer<float> output;
+        output.makeCopyOf(input);
+
+        if (! prepareProcessor(processor, settings, 2, 48000.0, blockSize))
+            return {};
+
+        auto getIndex = [&processor](const char* id) { return processor.getParameters().indexOf(processor.parameters.getParameter(id)); };
+        auto* threshold = processor.parameters.getParameter("threshold");
+        auto numSamples = output.getNumSamples();
+        juce::MidiBuffer midi;
+
+        for (int start = 0; start < numSamples; start += blockSize)
+        {
+            auto n = juce::jmin(blockSize, numSamples - start);
+
+            for (auto i = (start + 31) / 32 * 32; i < start + n; i += 32)
+                processor.addParameterChange(i - start, getIndex("threshold"),
+                                             threshold->convertTo0to1(-10.0f - 30.0f * (float)i / (float)numSamples));
+
+            for (auto& step : steps)
+                if (step.position >= start && step.position < start + n)
+                    processor.addParameterChange(step.position - start, getIndex(step.id),
+                                                 processor.parameters.getParameter(step.id)->convertTo0to1(step.value));
+
+            juce::AudioBuffer<float> block(output.getArrayOfWritePointers(), 2, start, n);
+            processor.processBlock(block, midi);
+        }
+
+        return output;
+    }
+
+    // Offline output has to be the same at any block size, with automation
+    // landing on the same samples; the silent stretch checks that no block
+    // size takes the silence fast path where another does not.
+    bool verifyAutomation(const BenchSettings& settings)
+    {
+        juce::AudioBuffer<float> input(2, 48000 * 2);
+        generateSignal("drums", input, 48000.0);
+        input.clear(50000, 12000);
+
+        auto ok = true;
+
+        for (auto* bands : { "0", "2" })
+        {
+            auto configured = settings;
+            configured.parameterValues.set("bands", bands);
+            configured.parameterValues.set("lookahead", "3");
+
+            auto reference = renderAutomated(configured, input, 4096);
+            auto worstError = 0.0f;
+
+            for (auto blockSize : { 441, 32, 7 })
+            {
+                auto output = renderAutomated(configured, input, blockSize);
+
+                for (int ch = 0; ch < 2; ++ch)
+                    for (int i = 0; i < input.getNumSamples(); ++i)
+                        worstError = juce::jmax(worstError, std::abs(output.getSample(ch, i) - reference.getSample(ch, i)));
+            }
+
+            auto passed = reference.getNumSamples() > 0 && worstError == 0.0f;
+            ok = ok && passed;
+
+            std::cout << "verify automation (" << (juce::String(bands) == "0" ? "single band" : "3 bands")
+                      << ", block sizes 4096/441/32/7): max difference " << worstError << (passed ? "  ok" : "  FAILED") << std::endl;
+        }
+
+        return ok;
+    }
+
+    // The meter against EBU Tech 3341 and 3342: a stereo sine at -20 dBFS
+    // reads -20 LUFS, and 20 s of it followed by 20 s at -30 dBFS a range of
+    // 10 LU. Then auto makeup has to bring a sine at -36 dBFS to its target.
+    bool verifyLoudness(const BenchSettings& settings)
+    {
+        constexpr double sampleRate = 48000.0;
+
+        juce::AudioBuffer<float> tone(2, (int)sampleRate * 20);
+        generateSignal("sine", tone, sampleRate);
+        tone.applyGain(juce::Decibels::decibelsToGain(-20.0f) / 0.5f);
+
+        LoudnessMeter<float> meter;
+        meter.prepare(sampleRate, LoudnessMeterBase::getChannelWeights(juce::AudioChannelSet::stereo(), 2));
+        meter.process(tone.getArrayOfReadPointers(), 2, 0, tone.getNumSamples());
+        auto steady = meter.getSnapshot();
+
+        tone.applyGain(juce::Decibels::decibelsToGain(-10.0f));
+        meter.process(tone.getArrayOfReadPointers(), 2, 0, tone.getNumSamples());
+        auto stepped = meter.getSnapshot();
+
+        auto within = [](float value, float expected, float tolerance) { return std::abs(value - expected) <= tolerance; };
+        auto meterOk = within(steady.momentary, -20.0f, 0.1f) && within(steady.shortTerm, -20.0f, 0.1f)
+                       && within(steady.integrated, -20.0f, 0.1f) && within(stepped.range, 10.0f, 1.0f)
+                       && within(steady.truePeak, -20.0f, 0.2f);
+
+        std::cout << "verify loudness: M " << steady.momentary << ", S " << steady.shortTerm << ", I " << steady.integrated
+                  << " LUFS, true peak " << steady.truePeak << " dBTP; range " << stepped.range << " LU"
+                  << (meterOk ? "  ok" : "  FAILED") << std::endl;
+
+        auto configured = settings;
+        configured.parameterValues.set("ratio", "1");
+        configured.parameterValues.set("autoMakeup", "1");
+        configured.parameterValues.set("loudnessTarget", "-14");
+
+        OneCompAudioProcessor processor;
+
+        if (! prepareProcessor(processor, configured, 2, sampleRate, 512))
+            return false;
+
+        juce::AudioBuffer<float> input(2, (int)sampleRate * 12), block(2, 512);
+        generateSignal("sine", input, sampleRate);
+        input.applyGain(juce::Decibels::decibelsToGain(-36.0f) / 0.5f);
+        juce::MidiBuffer midi;
+
+        for (int start = 0; start + 512 <= input.getNumSamples(); start += 512)
+        {
+            for (int ch = 0; ch < 2; ++ch)
+                block.copyFrom(ch, 0, input, ch, start, 512);
+
+            processor.processBlock(block, midi);
+        }
+
+        auto output = processor.getLoudness();
+        auto makeupOk = within(output.shortTerm, -14.0f, 0.5f);
+
+        std::cout << "verify auto makeup: " << processor.getAutoMakeupGain() << " dB, output " << output.shortTerm
+                  << " LUFS for a target of -14" << (makeupOk ? "  ok" : "  FAILED") << std::endl;
+        return meterOk && makeupOk;
+    }
+
+    //==============================================================================
+    // Settings spread over the ranges and the link modes a bank supports, so
+    // that neighbouring lanes never share a curve.
+    CompressorBankBase::Parameters getBankParameters(int index)
+    {
+        using LinkMode = CompressorKernelBase::LinkMode;
+        const LinkMode links[] = { LinkMode::unlinked, LinkMode::linkedMax, LinkMode::linkedAverage };
+
+        juce::Random random(index + 1);
+        CompressorBankBase::Parameters params;
+        params.inputGainDb = random.nextFloat() * 12.0f - 6.0f;
+        params.makeupGainDb = random.nextFloat() * 6.0f;
+        params.thresholdDb = random.nextFloat() * -40.0f;
+        params.ratio = 1.0f + random.nextFloat() * 10.0f;
+        params.attackMs = 0.1f + random.nextFloat() * 20.0f;
+        params.releaseMs = 10.0f + random.nextFloat() * 300.0f;
+        params.kneeDb = random.nextFloat() * 12.0f;
+        params.link = links[index % 3];
+        return params;
+    }
+
+    CompressorKernelBase::Parameters toKernelParameters(const CompressorBankBase::Parameters& bank)
+    {
+        CompressorKernelBase::Parameters params;
+        params.inputGainDb = bank.inputGainDb;
+        params.makeupGainDb = bank.makeupGainDb;
+        params.thresholdDb = bank.thresholdDb;
+        params.ratio = bank.ratio;
+        params.attackMs = bank.attackMs;
+        params.releaseMs = bank.releaseMs;
+        params.kneeDb = bank.kneeDb;
+        params.link = bank.link;
+        return params;
+    }
+
+    // One stereo input per compressor: the test signals in turn, at
+    // different levels and with the right channel quieter, so linking matters.
+    template <typename SampleType>
+    void generateBankInput(const BenchSettings& settings, juce::AudioBuffer<SampleType>& buffer, int numCompressors, double sampleRate)
+    {
+        juce::AudioBuffer<float> source(2, buffer.getNumSamples());
+
+        for (int c = 0; c < numCompressors; ++c)
+        {
+            generateSignal(settings.signals[c % settings.signals.size()], source, sampleRate);
+            auto gain = juce::Decibels::decibelsToGain(-12.0f * (float)(c % 5) / 4.0f);
+
+            for (int ch = 0; ch < 2; ++ch)
+            {
+                auto* dest = buffer.getWritePointer(c * 2 + ch);
+                auto* from = source.getReadPointer(ch);
+                auto channelGain = ch == 0 ? gain : gain * 0.5f;
+
+                for (int i = 0; i < buffer.getNumSamples(); ++i)
+                    dest[i] = (SampleType)(from[i] * channelGain);
+            }
+        }
+    }
+
+    // The bank against one CompressorKernel per lane with the same settings.
+    // The gains are constant, so the outputs have to match exactly.
+    template <typename SampleType>
+    bool verifyBank(const BenchSettings& settings)
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr int numCompressors = 37; // not a whole register, so the padding lanes run too
+
+        juce::AudioBuffer<SampleType> banked(numCompressors * 2, 48000), reference;
+        generateBankInput(settings, banked, numCompressors, sampleRate);
+        reference.makeCopyOf(banked);
+
+        CompressorBank<SampleType> bank;
+        bank.prepare(sampleRate, numCompressors, 2);
+        std::vector<CompressorKernel<SampleType>> kernels((size_t)numCompressors);
+
+        for (int c = 0; c < numCompressors; ++c)
+        {
+            auto params = getBankParameters(c);
+            bank.setParameters(c, params);
+            kernels[(size_t)c].setParameters(toKernelParameters(params));
+            kernels[(size_t)c].prepare(sampleRate, 2);
+        }
+
+        bank.reset();
+
+        for (int start = 0; start < banked.getNumSamples(); start += 333)
+        {
+            auto n = juce::jmin(333, banked.getNumSamples() - start);
+            std::vector<SampleType*> channels;
+
+            for (int ch = 0; ch < banked.getNumChannels(); ++ch)
+                channels.push_back(banked.getWritePointer(ch, start));
+
+            bank.process(channels.data(), n);
+
+            for (int c = 0; c < numCompressors; ++c)
+            {
+                SampleType* pair[] = { reference.getWritePointer(c * 2, start), reference.getWritePointer(c * 2 + 1, start) };
+                kernels[(size_t)c].process(pair, 2, n);
+            }
+        }
+
+        auto samplesDiffering = 0;
+
+        for (int ch = 0; ch < banked.getNumChannels(); ++ch)
+            for (int i = 0; i < banked.getNumSamples(); ++i)
+                samplesDiffering += banked.getSample(ch, i) != reference.getSample(ch, i) ? 1 : 0;
+
+        auto passed = samplesDiffering == 0;
+        std::cout << "verify " << (std::is_same<SampleType, double>::value ? "double" : "float") << " bank of "
+                  << numCompressors << ": " << samplesDiffering << " samples differ" << (passed ? "  ok" : "  FAILED") << std::endl;
+        return passed;
+    }
+
+    struct BankResult
+    {
+        double kernelNsPerSample = 0, bankNsPerSample = 0;
+    };
+
+    // numCompressors stereo compressors at 48 kHz in 512-sample blocks, as
+    // separate kernels and as one bank. Only the processing is timed.
+    template <typename SampleType>
+    BankResult runBank(const BenchSettings& settings, int numCompressors)
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = 512;
+
+        juce::AudioBuffer<SampleType> source(numCompressors * 2, (int)sampleRate * 2), block(numCompressors * 2, blockSize);
+        generateBankInput(settings, source, numCompressors, sampleRate);
+
+        CompressorBank<SampleType> bank;
+        bank.prepare(sampleRate, numCompressors, 2);
+        std::vector<CompressorKernel<SampleType>> kernels((size_t)numCompressors);
+
+        for (int c = 0; c < numCompressors; ++c)
+        {
+            auto params = getBankParameters(c);
+            bank.setParameters(c, params);
+            kernels[(size_t)c].setParameters(toKernelParameters(params));
+            kernels[(size_t)c].prepare(sampleRate, 2);
+        }
+
+        bank.reset();
+
+        auto numBlocks = juce::jmax(1, (int)(settings.seconds * sampleRate) / blockSize);
+        auto numWarmupBlocks = juce::jmax(1, numBlocks / 10);
+        auto sourceLength = source.getNumSamples() - source.getNumSamples() % blockSize;
+        double kernelNs = 0.0, bankNs = 0.0;
+
+        for (int i = -numWarmupBlocks, position = 0; i < numBlocks; ++i)
+        {
+            for (int ch = 0; ch < block.getNumChannels(); ++ch)
+                block.copyFrom(ch, 0, source, ch, position, blockSize);
+
+            auto start = Clock::now();
+
+            for (int c = 0; c < numCompressors; ++c)
+            {
+                SampleType* pair[] = { block.getWritePointer(c * 2), block.getWritePointer(c * 2 + 1) };
+                kernels[(size_t)c].process(pair, 2, blockSize);
+            }
+
+            auto ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+            kernelNs += i >= 0 ? ns : 0.0;
+
+            for (int ch = 0; ch < block.getNumChannels(); ++ch)
+                block.copyFrom(ch, 0, source, ch, position, blockSize);
+
+            start = Clock::now();
+            bank.process(block.getArrayOfWritePointers(), blockSize);
+            ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+            bankNs += i >= 0 ? ns : 0.0;
+
+            position = (position + blockSize) % sourceLength;
+        }
+
+        auto numSamples = (double)numBlocks * blockSize * block.getNumChannels();
+        return { kernelNs / numSamples, bankNs / numSamples };
+    }
+
+    float getWorstParameterError(juce::AudioProcessor& a, juce::AudioProcessor& b)
+    {
+        auto worst = 0.0f;
+
+        for (int i = 0; i < a.getParameters().size(); ++i)
+        {
+            auto* pa = dynamic_cast<juce::RangedAudioParameter*>(a.getParameters()[i]);
+            auto* pb = dynamic_cast<juce::RangedAudioParameter*>(b.getParameters()[i]);
+            auto range = pa->getNormalisableRange().getRange().getLength();
+            worst = juce::jmax(worst, std::abs(pa->convertFrom0to1(pa->getValue()) - pb->convertFrom0to1(pb->getValue())) / range);
+        }
+
+        return worst;
+    }
+
+    // Random settings through the compact state and the legacy XML state must
+    // come back unchanged, and a state naming only some parameters must reset
+    // the rest. Also times both loads.
+    bool verifyState()
+    {
+        OneCompAudioProcessor source, compactTarget, xmlTarget;
+        juce::Random random(1);
+
+        for (auto* parameter : source.getParameters())
+            parameter->setValueNotifyingHost(random.nextFloat());
+
+        juce::MemoryBlock compact, xml;
+        source.getStateInformation(compact);
+        juce::AudioProcessor::copyXmlToBinary(*source.parameters.copyState().createXml(), xml);
+
+        auto time = [](juce::AudioProcessor& processor, const juce::MemoryBlock& state)
+        {
+            const int runs = 200;
+            auto start = Clock::now();
+
+            for (int i = 0; i < runs; ++i)
+                processor.setStateInformation(state.getData(), (int)state.getSize());
+
+            return std::chrono::duration<double, std::micro>(Clock::now() - start).count() / runs;
+        };
+
+        auto compactUs = time(compactTarget, compact);
+        auto xmlUs = time(xmlTarget, xml);
+        auto compactError = getWorstParameterError(source, compactTarget);
+        auto xmlError = getWorstParameterError(source, xmlTarget);
+
+        auto partial = CompactState::encode({ { "ratio", 4.0f }, { "band2Gain", -6.0f } });
+        compactTarget.setStateInformation(partial.getData(), (int)partial.getSize());
+
+        auto partialOk = true;
+
+        for (auto* parameter : compactTarget.getParameters())
+        {
+            auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter);
+            auto id = ranged->getParameterID();
+            auto expected = id == "ratio" ? 4.0f : id == "band2Gain" ? -6.0f : ranged->convertFrom0to1(ranged->getDefaultValue());
+            partialOk = partialOk && std::abs(ranged->convertFrom0to1(ranged->getValue()) - expected) < 1.0e-4f;
+        }
+
+        auto passed = compactError < 1.0e-6f && xmlError < 1.0e-6f && partialOk;
+        std::cout << "verify state: compact " << (int)compact.getSize() << " bytes, " << compactUs << " us per load, error "
+                  << compactError << "; xml " << (int)xml.getSize() << " bytes, " << xmlUs << " us per load, error "
+                  << xmlError << "; partial " << (partialOk ? "ok" : "wrong") << (passed ? "  ok" : "  FAILED") << std::endl;
+        return passed;
+    }
+
+    //==============================================================================
+    juce::var toJson(const BenchSettings& settings, const juce::Array<Result>& results)
+    {
+        auto* root = new juce::DynamicObject();
+        root->setProperty("label", settings.label);
+        root->setProperty("date", juce::Time::getCurrentTime().toISO8601(true));
+        root->setProperty("cpu", juce::SystemStats::getCpuModel());
+        root->setProperty("cores", juce::SystemStats::getNumCpuCores());
+        root->setProperty("juce", juce::SystemStats::getJUCEVersion());
+        root->setProperty("simd", (bool)JUCE_USE_SIMD);
+       #if JUCE_DEBUG
+        root->setProperty("build", "debug");
+       #else
+        root->setProperty("build", "release");
+       #endif
+        root->setProperty("secondsPerCase", settings.seconds);
+
+        auto* parameterValues = new juce::DynamicObject();
+
+        for (auto& id : settings.parameterValues.getAllKeys())
+            parameterValues->setProperty(id, settings.parameterValues[id].getDoubleValue());
+
+        root->setProperty("parameters", juce::var(parameterValues));
+
+        juce::Array<juce::var> cases;
+
+        for (auto& r : results)
+        {
+            auto* c = new juce::DynamicObject();
+            c->setProperty("signal", r.signal);
+            c->setProperty("sampleRate", r.sampleRate);
+            c->setProperty("blockSize", r.blockSize);
+            c->setProperty("channels", r.numChannels);
+            c->setProperty("precision", r.precision);
+            c->setProperty("nsPerSample", r.nsPerSample);
+            c->setProperty("realtimeFactor", r.realtimeFactor);
+            c->setProperty("p50us", r.p50Us);
+            c->setProperty("p99us", r.p99Us);
+            c->setProperty("maxUs", r.maxUs);
+            cases.add(juce::var(c));
+        }
+
+        root->setProperty("results", cases);
+        return juce::var(root);
+    }
+
+    void printComparison(const juce::File& baselineFile, const juce::Array<Result>& results)
+    {
+        auto baseline = juce::JSON::parse(baselineFile);
+        std::map<juce::String, double> previous;
+
+        if (auto* cases = baseline["results"].getArray())
+            for (auto& c : *cases)
+                previous[Result::makeKey(c["signal"].toString(), (int)c["sampleRate"], (int)c["blockSize"],
+                                         (int)c["channels"], c["precision"].toString())] = c["nsPerSample"];
+
+        std::cout << "\nvs " << baselineFile.getFileName() << " (" << baseline["label"].toString() << ")" << std::endl;
+
+        for (auto& r : results)
+        {
+            auto it = previous.find(r.getKey());
+
+            if (it != previous.end() && it->second > 0.0)
+                std::cout << r.getKey().paddedRight(' ', 35) << juce::String((r.nsPerSample / it->second - 1.0) * 100.0, 1) << " %" << std::endl;
+        }
+    }
+
+    template <typename Type>
+    juce::Array<Type> parseList(const juce::String& text)
+    {
+        juce::Array<Type> values;
+
+        for (auto& token : juce::StringArray::fromTokens(text, ",", {}))
+            values.add((Type)token.getDoubleValue());
+
+        return values;
+    }
+
+    void printUsage()
+    {
+        std::cout << "Usage: oneCompBench [options]\n"
+                     "\n"
+                     "  --rates <list>         Sample rates, e.g. 44100,96000\n"
+                     "  --blocks <list>        Block sizes, e.g. 32,512\n"
+                     "  --channels <list>      Channel counts, e.g. 1,2\n"
+                     "  --signals <list>       Any of silence,sine,pink,drums\n"
+                     "  --precision <list>     Any of float,double (default float)\n"
+                     "  --seconds <n>          Audio processed per case (default 5)\n"
+                     "  --set <id>=<value>     Parameter value, e.g. --set oversampling=2 for 4x\n"
+                     "  --json <file>          Write results as JSON\n"
+                     "  --compare <file>       Print ns/sample change against an earlier JSON run\n"
+                     "  --label <text>         Stored in the JSON, e.g. a commit hash\n"
+                     "  --bank <list>          Compressor counts, e.g. 16,256: time that many stereo\n"
+                     "                         kernels against one CompressorBank instead\n"
+                     "  --verify               Check the SIMD paths against their scalar references,\n"
+                     "                         in both precisions, and float against double; the\n"
+                     "                         silence path, bypass, block-size independence of\n"
+                     "                         automated offline renders, the saved state, and the\n"
+                     "                         loudness meter and auto makeup, and the compressor\n"
+                     "                         bank against separate kernels\n"
+                  << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+   #if defined (__AVX2__) && (defined (__GNUC__) || defined (__clang__))
+    // Built for AVX2 (ONECOMP_ARCH x86-64-v3 or later) but run without it:
+    // 77 is the code ctest reports as skipped.
+    if (! __builtin_cpu_supports("avx2"))
+    {
+        std::cout << "skipped: this benchmark was built for AVX2, which this CPU lacks" << std::endl;
+        return 77;
+    }
+   #endif
+
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    BenchSettings settings;
+    juce::StringArray args(argv + 1, argc - 1);
+
+    for (int i = 0; i < args.size(); ++i)
+    {
+        auto arg = args[i];
+        auto hasValue = i + 1 < args.size();
+
+        if (arg == "--rates" && hasValue)
+            settings.sampleRates = parseList<double>(args[++i]);
+        else if (arg == "--blocks" && hasValue)
+            settings.blockSizes = parseList<int>(args[++i]);
+        else if (arg == "--channels" && hasValue)
+            settings.channelCounts = parseList<int>(args[++i]);
+        else if (arg == "--signals" && hasValue)
+            settings.signals = juce::StringArray::fromTokens(args[++i], ",", {});
+        else if (arg == "--precision" && hasValue)
+            settings.precisions = juce::StringArray::fromTokens(args[++i], ",", {});
+        else if (arg == "--seconds" && hasValue)
+            settings.seconds = juce::jmax(0.1, args[++i].getDoubleValue());
+        else if (arg == "--json" && hasValue)
+            settings.jsonFile = juce::File::getCurrentWorkingDirectory().getChildFile(args[++i]);
+        else if (arg == "--compare" && hasValue)
+            settings.compareFile = juce::File::getCurrentWorkingDirectory().getChildFile(args[++i]);
+        else if (arg == "--label" && hasValue)
+            settings.label = args[++i];
+        else if (arg == "--set" && hasValue && args[i + 1].contains("="))
+        {
+            auto assignment = args[++i];
+            settings.parameterValues.set(assignment.upToFirstOccurrenceOf("=", false, false).trim(),
+                                         assignment.fromFirstOccurrenceOf("=", false, false).trim());
+        }
+        else if (arg == "--bank" && hasValue)
+            settings.bankSizes = parseList<int>(args[++i]);
+        else if (arg == "--verify")
+            settings.verify = true;
+        else
+        {
+            printUsage();
+            return arg == "-h" || arg == "--help" ? 0 : 1;
+        }
+    }
+
+    if (settings.verify)
+    {
+        auto curveOk = verifyGainComputer<float>() && verifyGainComputer<double>();
+        auto kernelOk = verifyKernel<float>(settings) && verifyKernel<double>(settings);
+        auto multibandOk = verifyMultiband<float>(settings) && verifyMultiband<double>(settings);
+        auto precisionOk = verifyPrecision(settings);
+        auto silenceOk = verifySilence();
+        auto bypassOk = verifyBypass(settings);
+        auto automationOk = verifyAutomation(settings);
+        auto stateOk = verifyState();
+        auto loudnessOk = verifyLoudness(settings);
+        auto bankOk = verifyBank<float>(settings) && verifyBank<double>(settings);
+        return curveOk && kernelOk && multibandOk && precisionOk && silenceOk && bypassOk && automationOk && stateOk
+                   && loudnessOk && bankOk ? 0 : 1;
+    }
+
+    if (! settings.bankSizes.isEmpty())
+    {
+        std::cout << "compressors  prec    kernels ns/sample    bank ns/sample    speedup" << std::endl;
+
+        for (auto numCompressors : settings.bankSizes)
+        {
+            for (auto& precision : settings.precisions)
+            {
+                auto r = precision == "double" ? runBank<double>(settings, juce::jmax(1, numCompressors))
+                                               : runBank<float>(settings, juce::jmax(1, numCompressors));
+
+                std::cout << juce::String(numCompressors).paddedLeft(' ', 11)
+                          << precision.paddedLeft(' ', 6)
+                          << juce::String(r.kernelNsPerSample, 3).paddedLeft(' ', 21)
+                          << juce::String(r.bankNsPerSample, 3).paddedLeft(' ', 18)
+                          << juce::String(r.bankNsPerSample > 0.0 ? r.kernelNsPerSample / r.bankNsPerSample : 0.0, 2).paddedLeft(' ', 10)
+                          << "x" << std::endl;
+            }
+        }
+
+        return 0;
+    }
+
+    juce::Array<Result> results;
+
+    std::cout << "signal    rate    block  ch  prec    ns/sample     x realtime    p50 us    p99 us    max us" << std::endl;
+
+    for (auto& signal : settings.signals)
+    {
+        for (auto sampleRate : settings.sampleRates)
+        {
+            for (auto numChannels : settings.channelCounts)
+            {
+                juce::AudioBuffer<float> source(numChannels, (int)sampleRate * 2);
+                generateSignal(signal, source, sampleRate);
+
+                for (auto blockSize : settings.blockSizes)
+                {
+                    for (auto& precision : settings.precisions)
+                    {
+                        auto r = precision == "double" ? runOne<double>(settings, signal, source, sampleRate, blockSize, numChannels)
+                                                       : runOne<float>(settings, signal, source, sampleRate, blockSize, numChannels);
+                        results.add(r);
+
+                        std::cout << signal.paddedRight(' ', 8)
+                                  << juce::String((int)sampleRate).paddedLeft(' ', 7)
+                                  << juce::String(blockSize).paddedLeft(' ', 8)
+                                  << juce::String(numChannels).paddedLeft(' ', 4)
+                                  << r.precision.paddedLeft(' ', 8)
+                                  << juce::String(r.nsPerSample, 3).paddedLeft(' ', 12)
+                                  << juce::String(r.realtimeFactor, 0).paddedLeft(' ', 15)
+                                  << juce::String(r.p50Us, 2).paddedLeft(' ', 10)
+                                  << juce::String(r.p99Us, 2).paddedLeft(' ', 10)
+                                  << juce::String(r.maxUs, 2).paddedLeft(' ', 10) << std::endl;
+                    }
+                }
+            }
+        }
+    }
+
+    if (settings.jsonFile != juce::File())
+    {
+        if (! settings.jsonFile.replaceWithText(juce::JSON::toString(toJson(settings, results))))
+        {
+            std::cerr << "Cannot write " << settings.jsonFile.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+
+    if (settings.compareFile.existsAsFile())
+        printComparison(settings.compareFile, results);
+
+    return 0;
+}
@@ -0,0 +1,755 @@
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+#include "../../Shared/StreamingAudioReader.h"
+
+#include <iostream>
+
+namespace
+{
+    // Breakpoints from --automate, in seconds and the parameter's own units,
+    // joined by straight lines and held before the first and after the last.
+    struct AutomationLane
+    {
+        juce::String id;
+        juce::Array<juce::Point<double>> points;
+
+        double getValueAt(double seconds) const
+        {
+            if (seconds <= points.getFirst().x)
+                return points.getFirst().y;
+
+            for (int i = 1; i < points.size(); ++i)
+            {
+                auto a = points.getReference(i - 1), b = points.getReference(i);
+
+                if (seconds < b.x)
+                    return a.y + (b.y - a.y) * (seconds - a.x) / (b.x - a.x);
+            }
+
+            return points.getLast().y;
+        }
+    };
+
+    // Lanes are sampled on this grid, counted from the start of the file, so
+    // a render comes out the same at any block size and with or without
+    // --segment.
+    constexpr int automationInterval = 32;
+
+    struct RenderSettings
+    {
+        juce::File outputDirectory;
+        juce::String suffix;
+        juce::MemoryBlock state;
+        juce::StringPairArray parameterValues;
+        juce::Array<AutomationLane> automation;
+        int blockSize = 8192;
+        int numThreads = juce::SystemStats::getNumCpuCores();
+        double segmentSeconds = 0.0;
+        bool verify = false;
+    };
+
+    juce::CriticalSection consoleLock;
+
+    void log(const juce::String& message)
+    {
+        const juce::ScopedLock sl(consoleLock);
+        std::cout << message << std::endl;
+    }
+
+    void printUsage()
+    {
+        std::cout << "Usage: oneCompRender [options] <files or folders...>\n"
+                     "\n"
+                     "  -o, --output <dir>     Folder for rendered files (required)\n"
+                     "  --suffix <text>        Appended to each output file name\n"
+                     "  --state <file>         Saved plugin state to load before rendering\n"
+                     "  --set <id>=<value>     Parameter value, e.g. --set threshold=-18\n"
+                     "  --automate <id>=<s>:<value>,...\n"
+                     "                         Automation breakpoints, e.g. threshold=0:-10,30:-30;\n"
+                     "                         not for lookahead, oversampling, oversamplingFilter\n"
+                     "                         or bands, which change the latency\n"
+                     "  --block-size <n>       Samples per processBlock call (default 8192)\n"
+                     "  -j, --threads <n>      Worker threads (default: one per core)\n"
+                     "  --segment <seconds>    Split each file into segments of this length and\n"
+                     "                         render them on all threads (default: whole files,\n"
+                     "                         one per thread); not with autoMakeup\n"
+                     "  --verify               With --segment, check the result against a\n"
+                     "                         single-threaded render\n"
+                  << std::endl;
+    }
+
+    int chooseBitDepth(juce::AudioFormat& format, int wanted)
+    {
+        auto depths = format.getPossibleBitDepths();
+
+        if (depths.contains(wanted) || depths.isEmpty())
+            return wanted;
+
+        return depths.getLast();
+    }
+
+    juce::Result applySettings(OneCompAudioProcessor& processor, const RenderSettings& settings)
+    {
+        if (settings.state.getSize() > 0)
+            processor.setStateInformation(settings.state.getData(), (int)settings.state.getSize());
+
+        for (auto& id : settings.parameterValues.getAllKeys())
+        {
+            auto* param = processor.parameters.getParameter(id);
+
+            if (param == nullptr)
+                return juce::Result::fail("Unknown parameter '" + id + "'");
+
+            param->setValueNotifyingHost(param->convertTo0to1(settings.parameterValues[id].getFloatValue()));
+        }
+
+        // The output is trimmed by the latency reported when the processor is
+        // prepared. These parameters change it, and a render has no message
+        // loop to report the change or a host to compensate for it.
+        static const juce::StringArray latencyParameters{ "lookahead", "oversampling", "oversamplingFilter", "bands" };
+
+        for (auto& lane : settings.automation)
+        {
+            if (processor.parameters.getParameter(lane.id) == nullptr)
+                return juce::Result::fail("Unknown parameter '" + lane.id + "'");
+
+            if (latencyParameters.contains(lane.id))
+                return juce::Result::fail("'" + lane.id + "' changes the latency and cannot be automated; use --set");
+        }
+
+        // Auto makeup follows the loudness of everything rendered before it
+        // and holds its gain through quiet passages, so no pre-roll brings a
+        // segment to the state a whole-file render would be in.
+        if (settings.segmentSeconds > 0.0)
+        {
+            auto autoMakeup = processor.parameters.getRawParameterValue("autoMakeup")->load() >= 0.5f;
+
+            for (auto& lane : settings.automation)
+                autoMakeup = autoMakeup || lane.id == "autoMakeup";
+
+            if (autoMakeup)
+                return juce::Result::fail("--segment cannot be used with autoMakeup; render whole files instead");
+        }
+
+        return juce::Result::ok();
+    }
+
+    // Queues the automation for the block at 'position': each lane's value
+    // at the grid point at or before the block's start, then every change at
+    // the grid points inside it.
+    void addAutomation(OneCompAudioProcessor& processor, const RenderSettings& settings, double sampleRate,
+                       juce::int64 position, int numSamples)
+    {
+        for (auto& lane : settings.automation)
+        {
+            auto* param = processor.parameters.getParameter(lane.id);
+            auto index = processor.getParameters().indexOf(param);
+            auto previous = -1.0f;
+
+            for (auto point = position - position % automationInterval; point < position + numSamples; point += automationInterval)
+            {
+                auto value = param->convertTo0to1((float)lane.getValueAt((double)point / sampleRate));
+
+                if (value != previous)
+                    processor.addParameterChange((int)juce::jmax((juce::int64)0, point - position), index, value);
+
+                previous = value;
+            }
+        }
+    }
+
+    // Sets the layout for the file's channel count and prepares. The sidechain
+    // bus has no source offline, so it is switched off.
+    bool prepareForFile(OneCompAudioProcessor& processor, int numChannels, double sampleRate, int blockSize)
+    {
+        auto channelSet = juce::AudioChannelSet::canonicalChannelSet(numChannels);
+
+        auto layout = processor.getBusesLayout();
+        layout.getChannelSet(true, 0) = channelSet;
+        layout.getChannelSet(false, 0) = channelSet;
+
+        if (layout.inputBuses.size() > 1)
+            layout.getChannelSet(true, 1) = juce::AudioChannelSet::disabled();
+
+        if (channelSet.isDisabled() || ! processor.setBusesLayout(layout))
+            return false;
+
+        processor.setNonRealtime(true);
+        processor.prepareToPlay(sampleRate, blockSize);
+        return true;
+    }
+
+    juce::Result createWriter(juce::AudioFormatManager& formats, const juce::File& input, const juce::AudioFormatReader& reader,
+                              const RenderSettings& settings, std::unique_ptr<juce::AudioFormatWriter>& writer)
+    {
+        auto* format = formats.findFormatForFileExtension(input.getFileExtension());
+
+        if (format == nullptr)
+            return juce::Result::fail("no writer for " + input.getFileExtension());
+
+        auto output = settings.outputDirectory.getChildFile(input.getFileNameWithoutExtension()
+                                                            + settings.suffix + input.getFileExtension());
+        output.deleteFile();
+
+        std::unique_ptr<juce::OutputStream> stream(output.createOutputStream());
+
+        if (stream == nullptr)
+            return juce::Result::fail("cannot write " + output.getFullPathName());
+
+        writer.reset(format->createWriterFor(stream.get(), reader.sampleRate, reader.numChannels,
+                                             chooseBitDepth(*format, (int)reader.bitsPerSample),
+                                             reader.metadataValues, 0));
+        if (writer == nullptr)
+            return juce::Result::fail("cannot create " + format->getFormatName() + " writer");
+
+        stream.release();
+        return juce::Result::ok();
+    }
+
+    // Processes the source from 'position' on, in blocks on the same grid as
+    // a whole-file render, and passes the output that lines up with source
+    // samples [start, end) to 'sink' as (buffer, offset in it, source index,
+    // count). The reader pads with silence past the end, which flushes the
+    // lookahead delay. Returns the position reached, end + latency, or -1 if
+    // reading or the sink failed.
+    template <typename Sink>
+    juce::int64 renderRange(OneCompAudioProcessor& processor, StreamingAudioReader& reader,
+                            juce::AudioBuffer<float>& buffer, juce::int64 position, juce::int64 start,
+                            juce::int64 end, const RenderSettings& settings, Sink&& sink)
+    {
+        auto blockSize = settings.blockSize;
+        auto latency = (juce::int64)processor.getLatencySamples();
+        juce::MidiBuffer midi;
+
+        while (position < end + latency)
+        {
+            auto blockEnd = juce::jmin((position / blockSize + 1) * blockSize, end + latency);
+            auto numSamples = (int)(blockEnd - position);
+            buffer.setSize((int)reader.getFormat().numChannels, numSamples, false, false, true);
+
+            if (! reader.read(buffer, numSamples, position))
+                return -1;
+
+            addAutomation(processor, settings, reader.getFormat().sampleRate, position, numSamples);
+            processor.processBlock(buffer, midi);
+
+            // Output sample i of the block is source sample position + i - latency.
+            auto first = juce::jmax(position, start + latency);
+
+            if (first < blockEnd && ! sink(buffer, (int)(first - position), first - latency, (int)(blockEnd - first)))
+                return -1;
+
+            position = blockEnd;
+        }
+
+        return position;
+    }
+
+    // What the loudness meter read over everything written to a file.
+    void logLoudness(const juce::File& input, const LoudnessMeter<float>& meter)
+    {
+        auto loudness = meter.getSnapshot();
+        auto format = [](float value) { return value > LoudnessMeterBase::minLoudness ? juce::String(value, 1) : juce::String("-inf"); };
+
+        log(input.getFileName() + ": " + format(loudness.integrated) + " LUFS integrated, range "
+            + juce::String(loudness.range, 1) + " LU, true peak " + format(loudness.truePeak) + " dBTP");
+    }
+
+    juce::Result renderFile(OneCompAudioProcessor& processor, juce::AudioFormatManager& formats,
+                            const juce::File& input, const RenderSettings& settings)
+    {
+        StreamingAudioReader reader(formats, input);
+
+        if (! reader.isValid())
+            return juce::Result::fail("not a readable audio file");
+
+        auto& format = reader.getFormat();
+        auto numChannels = (int)format.numChannels;
+
+        if (! prepareForFile(processor, numChannels, format.sampleRate, settings.blockSize))
+            return juce::Result::fail("unsupported channel count " + juce::String(numChannels));
+
+        std::unique_ptr<juce::AudioFormatWriter> writer;
+        auto created = createWriter(formats, input, format, settings, writer);
+
+        if (created.failed())
+            return created;
+
+        juce::AudioBuffer<float> buffer(numChannels, settings.blockSize);
+        LoudnessMeter<float> meter;
+        meter.prepare(format.sampleRate, LoudnessMeterBase::getChannelWeights(juce::AudioChannelSet::canonicalChannelSet(numChannels), numChannels));
+
+        auto written = renderRange(processor, reader, buffer, 0, 0, format.lengthInSamples, settings,
+                                   [&writer, &meter](const juce::AudioBuffer<float>& block, int offset, juce::int64, int count)
+                                   {
+                                       meter.process(block.getArrayOfReadPointers(), block.getNumChannels(), offset, count);
+                                       return writer->writeFromAudioSampleBuffer(block, offset, count);
+                                   });
+
+        processor.releaseResources();
+
+        if (written < 0)
+            return juce::Result::fail("read or write failed");
+
+        logLoudness(input, meter);
+        return juce::Result::ok();
+    }
+
+    // One worker per pool thread. Each owns a processor and pulls files off a
+    // shared counter until the list is exhausted.
+    class RenderJob : public juce::ThreadPoolJob
+    {
+    public:
+        RenderJob(OneCompAudioProcessor& p, const juce::Array<juce::File>& f,
+                  const RenderSettings& s, std::atomic<int>& next, std::atomic<int>& failed)
+            : juce::ThreadPoolJob("render"), processor(p), files(f), settings(s), nextFile(next), numFailed(failed)
+        {
+            formats.registerBasicFormats();
+        }
+
+        JobStatus runJob() override
+        {
+            for (auto index = nextFile++; index < files.size() && ! shouldExit(); index = nextFile++)
+            {
+                auto& file = files.getReference(index);
+                auto result = renderFile(processor, formats, file, settings);
+
+                if (result.wasOk())
+                {
+                    log("Rendered " + file.getFullPathName());
+                }
+                else
+                {
+                    ++numFailed;
+                    log("Failed " + file.getFullPathName() + ": " + result.getErrorMessage());
+                }
+            }
+
+            return jobHasFinished;
+        }
+
+    private:
+        OneCompAudioProcessor& processor;
+        const juce::Array<juce::File>& files;
+        const RenderSettings& settings;
+        std::atomic<int>& nextFile;
+        std::atomic<int>& numFailed;
+        juce::AudioFormatManager formats;
+    };
+
+    // Audio rendered ahead of each segment so the processor has forgotten its
+    // starting state by the segment's first sample: long enough for the
+    // slowest release, auto release's slow envelope included, to decay by
+    // 140 dB, plus the RMS window and the lookahead, plus half a second for
+    // the key filter, crossovers and oversampling filters.
+    juce::int64 getPreRollSamples(OneCompAudioProcessor& processor, double sampleRate)
+    {
+        auto value = [&processor](const juce::String& id) { return processor.parameters.getRawParameterValue(id)->load(); };
+        auto releaseMs = value("release");
+
+        for (int band = 1; band <= MultibandCompressorBase::maxBands; ++band)
+            releaseMs = juce::jmax(releaseMs, value("band" + juce::String(band) + "Release"));
+
+        if (value("autoRelease") >= 0.5f)
+            releaseMs *= AutoBallistics<float>::slowReleaseFactor;
+
+        // The release filter's time constant is releaseMs / 2 pi.
+        auto decaySeconds = std::log(1.0e7) / juce::MathConstants<double>::twoPi * releaseMs * 0.001;
+        auto seconds = decaySeconds + (LevelDetectorBase::maxRmsWindowMs + CompressorKernelBase::maxLookaheadMs) * 0.001 + 0.5;
+        return (juce::int64)std::ceil(seconds * sampleRate);
+    }
+
+    // A renderRange() sink that collects the output in 'destination', whose
+    // first sample is source sample 'start'.
+    auto collectInto(juce::AudioBuffer<float>& destination, juce::int64 start)
+    {
+        return [&destination, start](const juce::AudioBuffer<float>& block, int offset, juce::int64 index, int count)
+        {
+            for (int ch = 0; ch < block.getNumChannels(); ++ch)
+                destination.copyFrom(ch, (int)(index - start), block, ch, offset, count);
+
+            return true;
+        };
+    }
+
+    struct Segment
+    {
+        juce::AudioBuffer<float> audio;
+        std::atomic<bool> finished{ false };
+        bool ok = false;
+    };
+
+    // One file rendered in segments. Segment k covers source samples
+    // [k * segmentLength, (k + 1) * segmentLength).
+    struct SegmentedFile
+    {
+        juce::File input;
+        juce::int64 length = 0;
+        juce::int64 segmentLength = 0;
+        juce::int64 preRoll = 0;
+        juce::OwnedArray<Segment> segments;
+        std::atomic<int> nextSegment{ 0 };
+        std::atomic<int> numWritten{ 0 };
+        int maxAhead = 1; // rendered segments held in memory, at most
+
+        juce::Range<juce::int64> getRange(int index) const noexcept
+        {
+            auto start = index * segmentLength;
+            return { start, juce::jmin(length, start + segmentLength) };
+        }
+    };
+
+    // Renders segments until none are left, taking the next one as each is
+    // finished, so a slow segment never holds up the others. A worker waits
+    // rather than run more than maxAhead segments ahead of the writer.
+    class SegmentJob : public juce::ThreadPoolJob
+    {
+    public:
+        SegmentJob(OneCompAudioProcessor& p, SegmentedFile& f, const RenderSettings& s)
+            : juce::ThreadPoolJob("segment"), processor(p), file(f), settings(s)
+        {
+            formats.registerBasicFormats();
+        }
+
+        JobStatus runJob() override
+        {
+            StreamingAudioReader reader(formats, file.input);
+
+            for (auto index = file.nextSegment++; index < file.segments.size(); index = file.nextSegment++)
+            {
+                while (index >= file.numWritten.load() + file.maxAhead && ! shouldExit())
+                    juce::Thread::sleep(1);
+
+                auto& segment = *file.segments.getUnchecked(index);
+                segment.ok = ! shouldExit() && reader.isValid() && render(reader, segment, file.getRange(index));
+                segment.finished.store(true);
+            }
+
+            return jobHasFinished;
+        }
+
+    private:
+        bool render(StreamingAudioReader& reader, Segment& segment, juce::Range<juce::int64> range)
+        {
+            auto numChannels = (int)reader.getFormat().numChannels;
+
+            if (! prepareForFile(processor, numChannels, reader.getFormat().sampleRate, settings.blockSize))
+                return false;
+
+            // Starting the pre-roll on the block grid gives the same blocks
+            // as a whole-file render.
+            auto position = juce::jmax((juce::int64)0, range.getStart() - file.preRoll);
+            position -= position % settings.blockSize;
+
+            segment.audio.setSize(numChannels, (int)range.getLength());
+            return renderRange(processor, reader, buffer, position, range.getStart(), range.getEnd(),
+                               settings, collectInto(segment.audio, range.getStart())) >= 0;
+        }
+
+        OneCompAudioProcessor& processor;
+        SegmentedFile& file;
+        const RenderSettings& settings;
+        juce::AudioFormatManager formats;
+        juce::AudioBuffer<float> buffer;
+    };
+
+    // Splits one file into segments rendered on every worker and writes them
+    // in order as they finish. With a reference processor, a single-threaded
+    // render runs alongside the writer and every segment is compared with it.
+    juce::Result renderFileInSegments(juce::OwnedArray<OneCompAudioProcessor>& processors, OneCompAudioProcessor* reference,
+                                      juce::AudioFormatManager& formats, const juce::File& input, const RenderSettings& settings)
+    {
+        constexpr float maxDifferenceDb = -120.0f;
+
+        StreamingAudioReader reader(formats, input);
+
+        if (! reader.isValid())
+            return juce::Result::fail("not a readable audio file");
+
+        auto& format = reader.getFormat();
+        auto numChannels = (int)format.numChannels;
+
+        SegmentedFile file;
+        file.input = input;
+        file.length = format.lengthInSamples;
+        file.segmentLength = juce::jmax((juce::int64)settings.blockSize, (juce::int64)(settings.segmentSeconds * format.sampleRate));
+        file.preRoll = getPreRollSamples(*processors.getFirst(), format.sampleRate);
+        file.maxAhead = processors.size() + 2;
+
+        for (juce::int64 start = 0; start < file.length; start += file.segmentLength)
+            file.segments.add(new Segment());
+
+        if (reference != nullptr && ! prepareForFile(*reference, numChannels, format.sampleRate, settings.blockSize))
+            return juce::Result::fail("unsupported channel count " + juce::String(numChannels));
+
+        std::unique_ptr<juce::AudioFormatWriter> writer;
+        auto created = createWriter(formats, input, format, settings, writer);
+
+        if (created.failed())
+            return created;
+
+        log(input.getFileName() + ": " + juce::String(file.segments.size()) + " segments of "
+            + juce::String((double)file.segmentLength / format.sampleRate, 1) + " s, "
+            + juce::String((double)file.preRoll / format.sampleRate, 1) + " s pre-roll");
+
+        LoudnessMeter<float> meter;
+        meter.prepare(format.sampleRate, LoudnessMeterBase::getChannelWeights(juce::AudioChannelSet::canonicalChannelSet(numChannels), numChannels));
+
+        juce::ThreadPool pool(processors.size());
+        juce::OwnedArray<SegmentJob> jobs;
+
+        for (auto* processor : processors)
+            pool.addJob(jobs.add(new SegmentJob(*processor, file, settings)), false);
+
+        auto result = juce::Result::ok();
+        juce::AudioBuffer<float> referenceBuffer, referenceAudio;
+        juce::int64 referencePosition = 0, worstSample = 0;
+        auto maxDifference = 0.0f;
+
+        for (int index = 0; index < file.segments.size() && result.wasOk(); ++index)
+        {
+            auto& segment = *file.segments.getUnchecked(index);
+
+            while (! segment.finished.load())
+                juce::Thread::sleep(1);
+
+            if (! segment.ok)
+            {
+                result = juce::Result::fail("segment " + juce::String(index) + " failed");
+                break;
+            }
+
+            if (reference != nullptr)
+            {
+                auto range = file.getRange(index);
+                referenceAudio.setSize(numChannels, (int)range.getLength(), false, false, true);
+                referencePosition = renderRange(*reference, reader, referenceBuffer, referencePosition, range.getStart(),
+                                                range.getEnd(), settings, collectInto(referenceAudio, range.getStart()));
+
+                for (int ch = 0; ch < numChannels; ++ch)
+                {
+                    auto* rendered = segment.audio.getReadPointer(ch);
+                    auto* expected = referenceAudio.getReadPointer(ch);
+
+                    for (int i = 0; i < segment.audio.getNumSamples(); ++i)
+                    {
+                        auto difference = std::abs(rendered[i] - expected[i]);
+
+                        if (difference > maxDifference)
+                        {
+                            maxDifference = difference;
+                            worstSample = range.getStart() + i;
+                        }
+                    }
+                }
+            }
+
+            meter.process(segment.audio.getArrayOfReadPointers(), numChannels, 0, segment.audio.getNumSamples());
+
+            if (! writer->writeFromAudioSampleBuffer(segment.audio, 0, segment.audio.getNumSamples()))
+                result = juce::Result::fail("write failed");
+
+            segment.audio.setSize(0, 0);
+            ++file.numWritten;
+        }
+
+        // Stops workers still waiting for the writer after a failure.
+        pool.removeAllJobs(true, -1);
+
+        if (result.wasOk())
+            logLoudness(input, meter);
+
+        if (result.wasOk() && reference != nullptr)
+        {
+            auto differenceDb = juce::Decibels::gainToDecibels(maxDifference, -200.0f);
+
+            if (maxDifference == 0.0f)
+                log(input.getFileName() + ": identical to a single-threaded render");
+            else
+                log(input.getFileName() + ": largest difference from a single-threaded render "
+                    + juce::String(differenceDb, 1) + " dBFS, at sample " + juce::String(worstSample));
+
+            if (differenceDb > maxDifferenceDb)
+                result = juce::Result::fail("differs from a single-threaded render by more than "
+                                            + juce::String(maxDifferenceDb, 0) + " dBFS");
+        }
+
+        return result;
+    }
+
+    void addInputs(const juce::String& path, const juce::String& wildcard, juce::Array<juce::File>& files)
+    {
+        auto file = juce::File::getCurrentWorkingDirectory().getChildFile(path);
+
+        if (file.isDirectory())
+        {
+            for (auto& entry : juce::RangedDirectoryIterator(file, true, wildcard, juce::File::findFiles))
+                files.add(entry.getFile());
+        }
+        else
+        {
+            files.add(file);
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    RenderSettings settings;
+    juce::Array<juce::File> files;
+    juce::StringArray args(argv + 1, argc - 1);
+
+    for (int i = 0; i < args.size(); ++i)
+    {
+        auto arg = args[i];
+        auto hasValue = i + 1 < args.size();
+
+        if ((arg == "-o" || arg == "--output") && hasValue)
+            settings.outputDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(args[++i]);
+        else if (arg == "--suffix" && hasValue)
+            settings.suffix = args[++i];
+        else if (arg == "--state" && hasValue)
+        {
+            auto stateFile = juce::File::getCurrentWorkingDirectory().getChildFile(args[++i]);
+
+            if (! stateFile.loadFileAsData(settings.state))
+            {
+                std::cerr << "Cannot read state file " << stateFile.getFullPathName() << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--set" && hasValue && args[i + 1].contains("="))
+        {
+            auto assignment = args[++i];
+            settings.parameterValues.set(assignment.upToFirstOccurrenceOf("=", false, false).trim(),
+                                         assignment.fromFirstOccurrenceOf("=", false, false).trim());
+        }
+        else if (arg == "--automate" && hasValue && args[i + 1].contains("="))
+        {
+            auto assignment = args[++i];
+            AutomationLane lane{ assignment.upToFirstOccurrenceOf("=", false, false).trim(), {} };
+
+            for (auto& breakpoint : juce::StringArray::fromTokens(assignment.fromFirstOccurrenceOf("=", false, false), ",", {}))
+                lane.points.add({ breakpoint.upToFirstOccurrenceOf(":", false, false).getDoubleValue(),
+                                  breakpoint.fromFirstOccurrenceOf(":", false, false).getDoubleValue() });
+
+            std::sort(lane.points.begin(), lane.points.end(), [](auto a, auto b) { return a.x < b.x; });
+
+            if (lane.points.isEmpty())
+            {
+                std::cerr << "No breakpoints in --automate " << assignment << std::endl;
+                return 1;
+            }
+
+            settings.automation.add(lane);
+        }
+        else if (arg == "--block-size" && hasValue)
+            settings.blockSize = juce::jlimit(16, 1 << 20, args[++i].getIntValue());
+        else if ((arg == "-j" || arg == "--threads") && hasValue)
+            settings.numThreads = juce::jmax(1, args[++i].getIntValue());
+        else if (arg == "--segment" && hasValue)
+            settings.segmentSeconds = juce::jmax(1.0, args[++i].getDoubleValue());
+        else if (arg == "--verify")
+            settings.verify = true;
+        else if (arg == "-h" || arg == "--help")
+        {
+            printUsage();
+            return 0;
+        }
+        else if (arg.startsWith("-"))
+        {
+            std::cerr << "Unknown option " << arg << std::endl;
+            printUsage();
+            return 1;
+        }
+        else
+            addInputs(arg, formats.getWildcardForAllFormats(), files);
+    }
+
+    if (files.isEmpty() || settings.outputDirectory == juce::File())
+    {
+        printUsage();
+        return 1;
+    }
+
+    if (! settings.outputDirectory.createDirectory())
+    {
+        std::cerr << "Cannot create " << settings.outputDirectory.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    if (settings.automation.size() * (settings.blockSize / automationInterval + 1) > OneCompAudioProcessor::maxParameterChanges)
+    {
+        std::cerr << "Too many automated parameters for the block size; use a smaller --block-size" << std::endl;
+        return 1;
+    }
+
+    if (settings.verify && settings.segmentSeconds <= 0.0)
+    {
+        std::cerr << "--verify needs --segment" << std::endl;
+        return 1;
+    }
+
+    auto segmented = settings.segmentSeconds > 0.0;
+    auto numWorkers = segmented ? settings.numThreads : juce::jmin(settings.numThreads, files.size());
+
+    // Processors are built and configured here so that parameter and state
+    // changes happen on the message thread; workers only prepare and process.
+    // The last one is the single-threaded reference for --verify.
+    juce::OwnedArray<OneCompAudioProcessor> processors;
+
+    for (int i = 0; i < numWorkers + (settings.verify ? 1 : 0); ++i)
+    {
+        auto* processor = processors.add(new OneCompAudioProcessor());
+        auto result = applySettings(*processor, settings);
+
+        if (result.failed())
+        {
+            std::cerr << result.getErrorMessage() << std::endl;
+            return 1;
+        }
+    }
+
+    std::unique_ptr<OneCompAudioProcessor> reference(settings.verify ? processors.removeAndReturn(numWorkers) : nullptr);
+    std::atomic<int> numFailed{ 0 };
+
+    if (segmented)
+    {
+        // One file at a time, each split across every worker.
+        for (auto& file : files)
+        {
+            auto result = renderFileInSegments(processors, reference.get(), formats, file, settings);
+
+            if (result.wasOk())
+            {
+                log("Rendered " + file.getFullPathName());
+            }
+            else
+            {
+                ++numFailed;
+                log("Failed " + file.getFullPathName() + ": " + result.getErrorMessage());
+            }
+        }
+
+        log(juce::String(files.size() - numFailed.load()) + " of " + juce::String(files.size()) + " files rendered");
+        return numFailed.load() == 0 ? 0 : 1;
+    }
+
+    std::atomic<int> nextFile{ 0 };
+    juce::ThreadPool pool(numWorkers);
+    juce::OwnedArray<RenderJob> jobs;
+
+    for (auto* processor : processors)
+        pool.addJob(jobs.add(new RenderJob(*processor, files, settings, nextFile, numFailed)), false);
+
+    for (auto* job : jobs)
+        pool.waitForJobToFinish(job, -1);
+
+    log(juce::String(files.size() - numFailed.load()) + " of " + juce::String(files.size()) + " files rendered");
+    return numFailed.load() == 0 ? 0 : 1;
+}
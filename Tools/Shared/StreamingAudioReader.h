@@ -0,0 +1,168 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Sequential block reads of an audio file of any length for the offline
+// tools, with resident memory independent of the file's length.
+//
+// WAV and AIFF files are memory-mapped one window at a time through two
+// juce::MemoryMappedAudioFormatReaders. While blocks are read from one
+// window, a background thread maps the next in the other and touches every
+// page of it, so the page faults land on that thread instead of the one
+// calling read(). Moving on unmaps the window behind, so at most two windows
+// are resident. The only copy is read()'s conversion from the file's
+// interleaved frames into the caller's buffer, which processBlock() then
+// works on in place.
+//
+// Other formats, FLAC among them, have no mapped reader and are decoded by
+// their ordinary reader, which streams as well.
+class StreamingAudioReader : private juce::Thread
+{
+public:
+    StreamingAudioReader(juce::AudioFormatManager& formats, const juce::File& file, int samplesPerWindow = 1 << 20)
+        : juce::Thread("oneComp prefetch"), windowLength(juce::jmax(1, samplesPerWindow))
+    {
+        if (auto* format = formats.findFormatForFileExtension(file.getFileExtension()))
+        {
+            current.reset(format->createMemoryMappedReader(file));
+            next.reset(format->createMemoryMappedReader(file));
+        }
+
+        if (current != nullptr && next != nullptr)
+        {
+            auto bytesPerFrame = juce::jmax(1, (int)current->numChannels * (int)current->bitsPerSample / 8);
+            samplesPerPage = juce::jmax(1, 4096 / bytesPerFrame);
+            startThread();
+        }
+        else
+        {
+            current.reset();
+            next.reset();
+            fallback.reset(formats.createReaderFor(file));
+        }
+    }
+
+    ~StreamingAudioReader() override
+    {
+        signalThreadShouldExit();
+        requested.signal();
+        stopThread(-1);
+    }
+
+    bool isValid() const noexcept { return current != nullptr || fallback != nullptr; }
+    bool isMapped() const noexcept { return current != nullptr; }
+
+    // For the format details: sample rate, channels, length and metadata.
+    const juce::AudioFormatReader& getFormat() const noexcept
+    {
+        return current != nullptr ? *current : *fallback;
+    }
+
+    // Fills samples [0, numSamples) of every channel of 'buffer' from
+    // 'position' on, with silence past the end of the file. Sequential
+    // reads never wait unless they overtake the prefetch; a jump elsewhere
+    // maps its window on the spot.
+    bool read(juce::AudioBuffer<float>& buffer, int numSamples, juce::int64 position)
+    {
+        if (fallback != nullptr)
+            return fallback->read(&buffer, 0, numSamples, position, true, true);
+
+        auto length = current->lengthInSamples;
+        auto done = 0;
+
+        while (done < numSamples && position < length)
+        {
+            auto* reader = getReaderFor(position);
+
+            if (reader == nullptr)
+                return false;
+
+            auto count = (int)juce::jmin((juce::int64)(numSamples - done), reader->getMappedSection().getEnd() - position);
+
+            if (! reader->read(&buffer, done, count, position, true, true))
+                return false;
+
+            done += count;
+            position += count;
+        }
+
+        if (done < numSamples)
+            buffer.clear(done, numSamples - done);
+
+        return true;
+    }
+
+private:
+    juce::MemoryMappedAudioFormatReader* getReaderFor(juce::int64 position)
+    {
+        if (isMapped(*current, position))
+            return current.get();
+
+        auto start = position - position % windowLength;
+
+        // The prefetch owns 'next' until it signals.
+        if (prefetchPending)
+        {
+            prefetched.wait(-1);
+            prefetchPending = false;
+        }
+
+        if (isMapped(*next, position))
+            std::swap(current, next);
+        else if (! current->mapSectionOfFile(getWindow(start)))
+            return nullptr;
+
+        auto following = getWindow(start + windowLength);
+
+        if (! following.isEmpty())
+        {
+            prefetchWindow = following;
+            prefetchPending = true;
+            requested.signal();
+        }
+
+        return isMapped(*current, position) ? current.get() : nullptr;
+    }
+
+    // A failed mapping leaves the old section in place, so the map is checked too.
+    // Sections are rounded out to whole pages, so one may start before its window.
+    static bool isMapped(const juce::MemoryMappedAudioFormatReader& reader, juce::int64 position) noexcept
+    {
+        return reader.getNumBytesUsed() > 0 && reader.getMappedSection().contains(position);
+    }
+
+    juce::Range<juce::int64> getWindow(juce::int64 start) const noexcept
+    {
+        return juce::Range<juce::int64>(start, start + windowLength).getIntersectionWith({ 0, current->lengthInSamples });
+    }
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            if (! requested.wait(-1) || threadShouldExit())
+                continue;
+
+            if (next->mapSectionOfFile(prefetchWindow))
+            {
+                for (auto sample = prefetchWindow.getStart(); sample < prefetchWindow.getEnd(); sample += samplesPerPage)
+                    next->touchSample(sample);
+            }
+
+            prefetched.signal();
+        }
+    }
+
+    const int windowLength;
+    int samplesPerPage = 1;
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> current, next;
+    std::unique_ptr<juce::AudioFormatReader> fallback;
+
+    // Set by the reading thread before 'requested' is signalled; the events
+    // order the hand-over of 'next' both ways.
+    juce::Range<juce::int64> prefetchWindow;
+    bool prefetchPending = false;
+    juce::WaitableEvent requested, prefetched;
+
+    JUCE_DECLARE_NON_COPYABLE(StreamingAudioReader)
+};